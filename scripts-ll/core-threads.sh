@@ -0,0 +1,60 @@
+#!/bin/bash
+
+# Speedup of the parallel multicore run (core_threads) over the serial one,
+# and how far its per-core IPC and run length are from the serial results,
+# for a few quanta and thread counts.
+#
+# usage: scripts-ll/core-threads.sh [config] trace1 trace2 ...
+#   e.g. scripts-ll/core-threads.sh configs/DDR3-config.cfg cputraces/*.gz
+
+config=configs/DDR3-config.cfg
+if [[ $1 == *.cfg ]]
+then
+    config=$1
+    shift
+fi
+
+traces="$@"
+
+quanta="20 100 400"
+
+threads="2 4 8"
+
+tmp=$(mktemp -d)
+
+TIMEFORMAT=%R
+
+# per-core IPC, one per line, from the stats of a run
+ipcs() {
+    paste <(grep "ramulator.cpu_instructions " $1 | awk '{print $2}') \
+          <(grep "ramulator.cpu_cycles " $1 | awk '{print $2}') | awk '{printf "%.6f\n", $1 / $2}'
+}
+
+cycles() {
+    grep "ramulator.cpu_cycles_main" $1 | awk '{print $2}'
+}
+
+sed "s/^ core_threads = .*/ core_threads = 1/" $config > $tmp/serial.cfg
+serial=$( { time ./ramulatorMulti $tmp/serial.cfg --mode=multicores --stats $tmp/serial.stats $traces > /dev/null ; } 2>&1 )
+ipcs $tmp/serial.stats > $tmp/serial.ipc
+printf "serial               %8ss\n" $serial
+
+for q in $quanta
+do
+    for t in $threads
+    do
+        sed -e "s/^ core_threads = .*/ core_threads = $t/" -e "s/^ core_quantum = .*/ core_quantum = $q/" $config > $tmp/$q-$t.cfg
+
+        secs=$( { time ./ramulatorMulti $tmp/$q-$t.cfg --mode=multicores --stats $tmp/$q-$t.stats $traces > /dev/null ; } 2>&1 )
+
+        ipcs $tmp/$q-$t.stats > $tmp/$q-$t.ipc
+        ipc_error=$(paste $tmp/serial.ipc $tmp/$q-$t.ipc | awk '{e = ($2 - $1) / $1 * 100; if (e < 0) e = -e; if (e > m) m = e} END {printf "%.3f", m}')
+        cycle_error=$(awk -v s=$(cycles $tmp/serial.stats) -v p=$(cycles $tmp/$q-$t.stats) 'BEGIN {printf "%+.3f", (p - s) / s * 100}')
+        speedup=$(awk -v s=$serial -v p=$secs 'BEGIN {printf "%.2f", s / p}')
+
+        printf "quantum=%-4d threads=%d %8ss  speedup %5sx  max ipc error %6s%%  cycles %7s%%\n" \
+            $q $t $secs $speedup $ipc_error $cycle_error
+    done
+done
+
+rm -rf $tmp
@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Scaling of the parallel channel ticking (memory_threads) with 1/2/4/8
+# threads, and a check that every run gives the same stats as the serial one.
+#
+# usage: scripts-ll/memory-threads.sh [mode] [trace]
+#   e.g. scripts-ll/memory-threads.sh cpu cpu.trace
+#        scripts-ll/memory-threads.sh dram dram.trace
+
+mode=${1:-cpu}
+
+trace=${2:-cpu.trace}
+
+configs="HBM WideIO2 WideIO LPDDR4"
+
+threads="1 2 4 8"
+
+tmp=$(mktemp -d)
+
+TIMEFORMAT=%R
+
+for std in $configs
+do
+    for t in $threads
+    do
+        sed "s/^ memory_threads = .*/ memory_threads = $t/" configs/$std-config.cfg > $tmp/$std-$t.cfg
+
+        secs=$( { time ./ramulatorMulti $tmp/$std-$t.cfg --mode=$mode --stats $tmp/$std-$t.stats $trace > /dev/null ; } 2>&1 )
+
+        # heap allocations depend on the threads that were started
+        if diff <(grep -v heap_allocations $tmp/$std-1.stats) <(grep -v heap_allocations $tmp/$std-$t.stats) > /dev/null
+        then
+            same="same stats"
+        else
+            same="STATS DIFFER"
+        fi
+
+        printf "%-8s threads=%d %8ss  %s\n" $std $t $secs "$same"
+    done
+done
+
+rm -rf $tmp
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Checks that multiprogram_metrics counts instructions alike in the alone
+# run and in the mix: a core whose trace has a writeback on every record
+# runs beside a core that barely touches memory, so its slowdown must come
+# out at 1.0. Exits non-zero when it does not.
+#
+# usage: scripts-ll/multiprogram-metrics.sh [config]
+#   the config has to be a DDR3 one, the only standard multicores mode runs
+
+config=${1:-configs/DDR3-config.cfg}
+
+tmp=$(mktemp -d)
+
+# 40 bubbles, a read and a writeback per record
+for i in $(seq 0 19999)
+do
+    echo "40 $((0x1000000 + i * 64)) $((0x8000000 + i * 64))"
+done > $tmp/writes.trace
+
+# a few reads far apart
+for i in 0 1 2
+do
+    echo "100000 $((0x20000000 + i * 64))"
+done > $tmp/idle.trace
+
+sed -e "s/^ cores_count = .*/ cores_count = 2/" -e "s/^ multiprogram_metrics = .*/ multiprogram_metrics = on/" \
+    -e "s/^ alone_cache = .*/ alone_cache = off/" $config > $tmp/mix.cfg
+./ramulatorMulti $tmp/mix.cfg --mode=multicores --stats $tmp/mix.stats $tmp/writes.trace $tmp/idle.trace > /dev/null
+
+slowdown=$(grep "ramulator.slowdown on core\[0\]" $tmp/mix.stats | awk '{print $4}')
+rm -rf $tmp
+
+printf "slowdown of the uncontended core with writes: %s\n" $slowdown
+awk -v s=$slowdown 'BEGIN {exit !(s > 0.99 && s < 1.01)}'
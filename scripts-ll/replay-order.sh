@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# Checks that an open-loop replay keeps a read behind an older write to its
+# line: a burst of writes saturates the write queue, then a write and a read
+# to one address arrive. The read has to reach the controller after that
+# write, which forwards it the data, so it never goes to DRAM and adds no
+# latency. It is checked in the replay of a text trace with timestamps, and
+# again in the replay of the timed trace captured from it. Exits non-zero
+# when the read went to DRAM.
+#
+# usage: scripts-ll/replay-order.sh [config]
+
+config=${1:-configs/DDR3-config.cfg}
+
+tmp=$(mktemp -d)
+
+# all in cycle 0: 256 writes to other lines, then a write and a read to one
+for i in $(seq 0 255)
+do
+    printf "0 0x%x W\n" $((0x100000 + i * 0x10000))
+done > $tmp/burst.trace
+echo "0 0x7000040 W" >> $tmp/burst.trace
+echo "0 0x7000040 R" >> $tmp/burst.trace
+
+sed -e "s/^ trace_timestamps = .*/ trace_timestamps = cycles/" \
+    -e "s|^ capture_trace = .*| capture_trace = $tmp/captured.trace|" $config > $tmp/capture.cfg
+sed -e "s/^ trace_timestamps = .*/ trace_timestamps = off/" -e "s/^ capture_trace = .*/ capture_trace = off/" \
+    $config > $tmp/replay.cfg
+
+./ramulatorMulti $tmp/capture.cfg --mode=dram --stats $tmp/capture.stats $tmp/burst.trace > /dev/null
+./ramulatorMulti $tmp/replay.cfg --mode=dram --stats $tmp/replay.stats $tmp/captured.trace > /dev/null
+
+# the read latency of channel 0, which only counts reads that went to DRAM,
+# if the one read was served
+latency() {
+    if grep -q "ramulator.read_requests  *1 " $1
+    then
+        grep "ramulator.read_latency_avg_0 " $1 | awk '{print $2}'
+    fi
+}
+text=$(latency $tmp/capture.stats)
+captured=$(latency $tmp/replay.stats)
+rm -rf $tmp
+
+printf "latency of the read behind a write to its address: %s replayed, %s from the capture\n" $text $captured
+awk -v t="$text" -v c="$captured" 'BEGIN {exit !(t != "" && c != "" && t == 0 && c == 0)}'
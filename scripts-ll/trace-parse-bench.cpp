@@ -0,0 +1,104 @@
+// Parsing throughput of text traces in MB/s: the Trace reader against the
+// getline/stoul parser it replaced, which is kept below as the baseline.
+//
+// build: make trace-parse-bench, which links the objects of the simulator
+//   with the libraries the Makefile found. By hand, on one line:
+//        g++ -O3 -std=c++11 -DRAMULATOR -Isrc scripts-ll/trace-parse-bench.cpp
+//            src/Config.cpp src/Processor.cpp src/StatType.cpp src/TraceGenerator.cpp
+//            src/TraceImporter.cpp src/TraceIndex.cpp src/TraceStream.cpp -lz -pthread
+//            -o trace-parse-bench
+//   adding -DRAMULATOR_ZSTD -lzstd and -DRAMULATOR_LZMA -llzma when the
+//   Makefile enables those.
+// usage: ./trace-parse-bench <cpu|dram> <text trace>
+
+#include "Processor.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+
+using namespace ramulator;
+
+// the parser before the batch reader, without its comment line printing
+static long baseline(const char* fname, bool dram, long& sum)
+{
+    std::ifstream file(fname);
+    std::string line;
+    long records = 0;
+    while (true) {
+        getline(file, line);
+        if (file.eof() || (!dram && line.size() == 0))
+            break;
+        size_t pos, end;
+        if (dram) {
+            sum += std::stoul(line, &pos, 16);
+            pos = line.find_first_not_of(' ', pos+1);
+            sum += pos != std::string::npos && line.substr(pos)[0] == 'W';
+        } else {
+            if (line.at(line.find_first_not_of(' ')) == '#')
+                continue;
+            sum += std::stoul(line, &pos, 10);
+            pos = line.find_first_not_of(' ', pos+1);
+            sum += stoul(line.substr(pos), &end, 0);
+            pos = line.find_first_not_of(' ', pos+end);
+            if (pos != std::string::npos)
+                sum += stoul(line.substr(pos), NULL, 0);
+        }
+        records++;
+    }
+    return records;
+}
+
+static long batch(const char* fname, bool dram, long& sum)
+{
+    Trace trace(fname);
+    long records = 0;
+    if (dram) {
+        long addr;
+        Request::Type type;
+        while (trace.get_request(addr, type)) {
+            sum += addr + (type == Request::Type::WRITE);
+            records++;
+        }
+    } else {
+        long bubble_cnt, read_addr, write_addr;
+        bool has_write;
+        while (trace.get_cpu_record(bubble_cnt, read_addr, has_write, write_addr)) {
+            sum += bubble_cnt + read_addr + (has_write ? write_addr : 0);
+            records++;
+        }
+    }
+    return records;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3 || (strcmp(argv[1], "cpu") && strcmp(argv[1], "dram"))) {
+        printf("usage: %s <cpu|dram> <text trace>\n", argv[0]);
+        return 1;
+    }
+    bool dram = !strcmp(argv[1], "dram");
+    struct stat st;
+    if (stat(argv[2], &st)) {
+        printf("Bad trace file: %s\n", argv[2]);
+        return 1;
+    }
+    double mb = st.st_size / 1e6;
+
+    const char* names[] = {"getline/stoul", "batch"};
+    long (*parsers[])(const char*, bool, long&) = {baseline, batch};
+    for (int p = 0; p < 2; p++) {
+        // best of a few runs, so that the file is in the page cache
+        double best = 0;
+        long records = 0, sum = 0;
+        for (int rep = 0; rep < 5; rep++) {
+            auto start = std::chrono::steady_clock::now();
+            records = parsers[p](argv[2], dram, sum);
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = std::max(best, mb / secs);
+        }
+        fprintf(stderr, "%-14s %9ld records %8.1f MB/s (checksum %ld)\n", names[p], records, best, sum / 5);
+    }
+    return 0;
+}
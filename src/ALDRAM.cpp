@@ -124,7 +124,7 @@ void ALDRAM::init_prereq()
         switch (int(node->state)) {
             case int(State::Closed): return Command::ACT;
             case int(State::Opened):
-                if (node->row_state.find(id) != node->row_state.end())
+                if (node->row_state.is_open(id))
                     return cmd;
                 return Command::PRE;
             default: assert(false);
@@ -172,7 +172,7 @@ void ALDRAM::init_rowhit()
         switch (int(node->state)) {
             case int(State::Closed): return false;
             case int(State::Opened):
-                if (node->row_state.find(id) != node->row_state.end())
+                if (node->row_state.is_open(id))
                     return true;
                 return false;
             default: assert(false);
@@ -187,7 +187,7 @@ void ALDRAM::init_lambda()
 {
     lambda[int(Level::Bank)][int(Command::ACT)] = [] (DRAM<ALDRAM>* node, int id) {
         node->state = State::Opened;
-        node->row_state[id] = State::Opened;};
+        node->row_state.open(id);};
     lambda[int(Level::Bank)][int(Command::PRE)] = [] (DRAM<ALDRAM>* node, int id) {
         node->state = State::Closed;
         node->row_state.clear();};
@@ -0,0 +1,125 @@
+#ifndef __BLOCKRING_H
+#define __BLOCKRING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace ramulator
+{
+
+// Lock-free ring of blocks between one producer and one consumer thread. The
+// producer fills a free block and publishes it; the consumer takes published
+// blocks in order and releases each one when it is done with it. Only block
+// counters are shared, so a whole block changes hands with one atomic store.
+// A thread that finds the ring full (or empty) spins for a while before it
+// goes to sleep on a condition variable; the other side only takes the lock
+// to wake it up when someone is actually asleep.
+template <typename T>
+class BlockRing
+{
+public:
+    typedef vector<T> Block;
+
+    BlockRing(int blocks, int block_size) : blocks(blocks)
+    {
+        for (auto& block : this->blocks)
+            block.reserve(block_size);
+    }
+
+    BlockRing(const BlockRing&) = delete;
+    BlockRing& operator=(const BlockRing&) = delete;
+
+    // Producer: the next block to fill, or NULL once the ring is stopped
+    Block* acquire()
+    {
+        long head = produced.load(memory_order_relaxed);
+        if (!wait([&] {return head - consumed.load() < long(blocks.size());}))
+            return NULL;
+        return &blocks[head % blocks.size()];
+    }
+
+    // Producer: hand the block from acquire() over to the consumer
+    void publish()
+    {
+        produced.fetch_add(1);
+        wake();
+    }
+
+    // Producer: wait until the consumer has released every published block,
+    // false once the ring is stopped
+    bool drain()
+    {
+        return wait([&] {return consumed.load() == produced.load(memory_order_relaxed);});
+    }
+
+    // Consumer: the oldest published block; waits until there is one
+    const Block& front()
+    {
+        long tail = consumed.load(memory_order_relaxed);
+        wait([&] {return produced.load() != tail;});
+        return blocks[tail % blocks.size()];
+    }
+
+    // Consumer: give the block from front() back to the producer
+    void release()
+    {
+        consumed.fetch_add(1);
+        wake();
+    }
+
+    // Make acquire() and drain() give up instead of waiting
+    void stop()
+    {
+        stopped.store(true);
+        wake();
+    }
+
+private:
+    vector<Block> blocks;
+    atomic<long> produced{0};  // blocks published so far
+    atomic<long> consumed{0};  // blocks released so far
+    atomic<bool> stopped{false};
+
+    // sleeping side; the counters and 'sleepers' are sequentially consistent
+    // so that a waiter either sees the update or is seen by wake()
+    mutex lock;
+    condition_variable cond;
+    atomic<int> sleepers{0};
+
+    static const int spin_limit = 1000;
+
+    // wait until ready() holds, false if the ring is stopped first
+    template <typename Ready>
+    bool wait(Ready ready)
+    {
+        for (int spins = 0; spins < spin_limit; spins++) {
+            if (stopped.load())
+                return false;
+            if (ready())
+                return true;
+        }
+        unique_lock<mutex> guard(lock);
+        sleepers.fetch_add(1);
+        while (!stopped.load() && !ready())
+            cond.wait(guard);
+        sleepers.fetch_sub(1);
+        return !stopped.load();
+    }
+
+    void wake()
+    {
+        if (sleepers.load() == 0)
+            return;
+        lock_guard<mutex> guard(lock);
+        cond.notify_all();
+    }
+};
+
+} /*namespace ramulator*/
+
+#endif /*__BLOCKRING_H*/
@@ -0,0 +1,405 @@
+#include "Cache.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace ramulator;
+
+static long get_long(const Config& configs, const string& option, long value)
+{
+    return configs.contains(option) ? atol(configs[option].c_str()) : value;
+}
+
+CacheStats::CacheStats(const string& level, int cores)
+    : level(level)
+{
+    hits
+        .init(cores)
+        .name(level + "_cache_hits")
+        .desc("Accesses that hit in the " + level + " cache, per core")
+        .precision(0)
+        ;
+    misses
+        .init(cores)
+        .name(level + "_cache_misses")
+        .desc("Accesses that missed in the " + level + " cache, per core, merged ones too")
+        .precision(0)
+        ;
+    mpki
+        .init(cores)
+        .name(level + "_cache_mpki")
+        .desc("Misses in the " + level + " cache per thousand instructions retired, per core")
+        .precision(4)
+        ;
+    mshr_merges
+        .name(level + "_cache_mshr_merges")
+        .desc("Misses in the " + level + " cache to a line already in flight")
+        .precision(0)
+        ;
+    mshr_rejects
+        .name(level + "_cache_mshr_rejects")
+        .desc("Times the " + level + " cache turned a miss down for lack of an MSHR")
+        .precision(0)
+        ;
+    writebacks
+        .name(level + "_cache_writebacks")
+        .desc("Dirty lines the " + level + " cache evicted and wrote back")
+        .precision(0)
+        ;
+    back_invalidations
+        .name(level + "_cache_back_invalidations")
+        .desc("Lines dropped from the " + level + " cache because an inclusive cache below evicted them")
+        .precision(0)
+        ;
+}
+
+Cache::Cache(CacheSystem* system, CacheStats* stats, long size, int ways, int latency, int mshrs,
+        Policy policy, Cache* lower)
+    : system(system), stats(stats), sets((size >> line_bits) / max(ways, 1)), ways(ways),
+      latency(latency), policy(policy), lower(lower), mshrs(mshrs)
+{
+    assert(ways > 0 && ways <= 255 && sets > 0 && mshrs > 0 && latency >= 0);
+    tags.resize(sets * ways, 0);
+    state.resize(sets * ways, policy == Policy::LRU ? 0 : max_rrpv);
+    if (policy == Policy::LRU)
+        for (long i = 0; i < sets * ways; i++)
+            state[i] = i % ways;
+}
+
+int Cache::find(long set, long line) const
+{
+    const uint64_t* tag = &tags[set * ways];
+    uint64_t want = uint64_t(line) << 2 | valid_bit;
+    for (int way = 0; way < ways; way++)
+        if ((tag[way] & ~dirty_bit) == want)
+            return way;
+    return -1;
+}
+
+Cache::Mshr* Cache::find_mshr(long line)
+{
+    for (auto& mshr : mshrs)
+        if (mshr.line == line)
+            return &mshr;
+    return NULL;
+}
+
+bool Cache::send(Request req)
+{
+    long line = req.addr >> line_bits;
+    long set = line % sets;
+    bool is_write = req.type == Request::Type::WRITE;
+
+    int way = find(set, line);
+    if (way >= 0) {
+        stats->hits[req.coreid]++;
+        touch(set, way);
+        if (is_write) {
+            tags[set * ways + way] |= dirty_bit;
+        } else {
+            req.arrive = req.depart = -1;  // not served by memory
+            system->callback_later(req, latency);
+        }
+        return true;
+    }
+
+    Mshr* mshr = find_mshr(line);
+    if (mshr) {
+        stats->misses[req.coreid]++;
+        stats->mshr_merges++;
+        if (is_write)
+            mshr->dirty = true;
+        else
+            mshr->reads.push_back(req);
+        return true;
+    }
+
+    if (is_write && !fetch_writes) {
+        stats->misses[req.coreid]++;
+        fill(line, true, req.coreid);
+        return true;
+    }
+
+    if (used_mshrs == int(mshrs.size())) {
+        stats->mshr_rejects++;
+        return false;
+    }
+    stats->misses[req.coreid]++;
+    mshr = find_mshr(-1);
+    mshr->line = line;
+    mshr->dirty = is_write;
+    if (!is_write)
+        mshr->reads.push_back(req);
+    used_mshrs++;
+    Request fetch(line << line_bits, Request::Type::READ, Callback::bind<Cache, &Cache::receive>(this), req.coreid);
+    system->send_later(lower, fetch, latency);
+    return true;
+}
+
+void Cache::receive(Request& req)
+{
+    long line = req.addr >> line_bits;
+    Mshr* mshr = find_mshr(line);
+    assert(mshr);
+    fill(line, mshr->dirty, req.coreid);
+    for (auto& read : mshr->reads) {
+        read.arrive = req.arrive;
+        read.depart = req.depart;
+        read.callback(read);
+    }
+    mshr->reads.clear();
+    mshr->line = -1;
+    mshr->dirty = false;
+    used_mshrs--;
+}
+
+void Cache::touch(long set, int way)
+{
+    uint8_t* rank = &state[set * ways];
+    if (policy == Policy::LRU) {
+        for (int i = 0; i < ways; i++)
+            if (rank[i] < rank[way])
+                rank[i]++;
+    }
+    rank[way] = 0;
+}
+
+/*
+ * put the line in its set, in place of the victim, which is written back
+ * if dirty. A new line is the most recent with LRU, and with RRIP is
+ * predicted to be re-referenced in a long time, or with bimodal RRIP in a
+ * distant time but for one in 32 fills. DRRIP uses bimodal RRIP in the
+ * sets that follow it when its leader sets miss less than those of SRRIP.
+ */
+void Cache::fill(long line, bool dirty, int coreid)
+{
+    long set = line % sets;
+    assert(find(set, line) < 0);
+    int way = victim(set);
+    uint64_t& tag = tags[set * ways + way];
+    if ((tag & valid_bit) && inclusive) {
+        for (auto cache : higher)
+            if (cache->invalidate(long(tag >> 2)))
+                tag |= dirty_bit;
+    }
+    if ((tag & valid_bit) && (tag & dirty_bit)) {
+        Request writeback(long(tag >> 2) << line_bits, Request::Type::WRITE, coreid);
+        system->send_later(lower, writeback, 0);
+        stats->writebacks++;
+    }
+    tag = uint64_t(line) << 2 | (dirty ? dirty_bit : 0) | valid_bit;
+
+    if (policy == Policy::LRU) {
+        touch(set, way);
+        return;
+    }
+    bool bimodal = false;
+    if (policy == Policy::DRRIP) {
+        int lead = leader(set);
+        if (lead == 1)
+            psel = min(psel + 1, 1023);
+        else if (lead == 2)
+            psel = max(psel - 1, 0);
+        bimodal = lead == 2 || (lead == 0 && psel >= 512);
+    }
+    if (bimodal && ++brrip_fills % 32)
+        state[set * ways + way] = max_rrpv;
+    else
+        state[set * ways + way] = max_rrpv - 1;
+}
+
+bool Cache::invalidate(long line)
+{
+    bool dirty = false;
+    for (auto cache : higher)
+        dirty |= cache->invalidate(line);
+    long set = line % sets;
+    int way = find(set, line);
+    if (way >= 0) {
+        dirty |= bool(tags[set * ways + way] & dirty_bit);
+        tags[set * ways + way] = 0;
+        stats->back_invalidations++;
+    }
+    return dirty;
+}
+
+int Cache::victim(long set)
+{
+    const uint64_t* tag = &tags[set * ways];
+    uint8_t* rank = &state[set * ways];
+    for (int way = 0; way < ways; way++)
+        if (!(tag[way] & valid_bit))
+            return way;
+    if (policy == Policy::LRU)
+        return max_element(rank, rank + ways) - rank;
+    while (true) {
+        for (int way = 0; way < ways; way++)
+            if (rank[way] == max_rrpv)
+                return way;
+        for (int way = 0; way < ways; way++)
+            rank[way]++;
+    }
+}
+
+// 1 for a leader set of SRRIP, 2 for one of bimodal RRIP, 0 for the others:
+// one of each in every 32 sets
+int Cache::leader(long set) const
+{
+    long group = set >> 5;
+    long offset = set & 31;
+    if (offset == (group & 31))
+        return 1;
+    if (offset == (~group & 31))
+        return 2;
+    return 0;
+}
+
+CacheSystem::CacheSystem(const Config& configs, int cores, function<bool(Request)> send_memory)
+    : send_memory(send_memory), first(cores, NULL)
+{
+    const string& inclusion = configs["cache_inclusion"];
+    if (inclusion != "" && inclusion != "inclusive" && inclusion != "non-inclusive") {
+        cerr << "Unknown cache_inclusion: " << inclusion << endl;
+        exit(1);
+    }
+
+    // the stats of the levels in order, L1 first
+    CacheStats* l1 = NULL;
+    CacheStats* l2 = NULL;
+    CacheStats* l3 = NULL;
+    if (configs.has_core_caches()) {
+        levels.push_back(l1 = new CacheStats("L1", cores));
+        levels.push_back(l2 = new CacheStats("L2", cores));
+    }
+    if (configs.has_l3_cache())
+        levels.push_back(l3 = new CacheStats("L3", cores));
+
+    Cache* llc = NULL;
+    if (l3)
+        llc = add(configs, l3, 8 << 20, 16, 31, 64, NULL);
+    for (int c = 0; c < cores; c++) {
+        first[c] = llc;
+        if (!l1)
+            continue;
+        Cache* l2_cache = add(configs, l2, 256 << 10, 8, 12, 32, llc);
+        first[c] = add(configs, l1, 32 << 10, 8, 4, 16, l2_cache);
+        first[c]->fetch_writes = true;
+    }
+    for (auto cache : caches)
+        cache->inclusive = inclusion == "inclusive";
+}
+
+CacheSystem::~CacheSystem()
+{
+    for (auto cache : caches)
+        delete cache;
+    for (auto level : levels)
+        delete level;
+}
+
+Cache* CacheSystem::add(const Config& configs, CacheStats* stats, long size, int ways, int latency,
+        int mshrs, Cache* lower)
+{
+    const string& level = stats->level;
+    string prefix = level;
+    transform(prefix.begin(), prefix.end(), prefix.begin(), ::tolower);
+    size = get_long(configs, prefix + "_size", size);
+    ways = get_long(configs, prefix + "_ways", ways);
+    latency = get_long(configs, prefix + "_latency", latency);
+    mshrs = get_long(configs, prefix + "_mshrs", mshrs);
+    if (ways <= 0 || ways > 255 || (size >> Cache::line_bits) / ways <= 0 || latency < 0 || mshrs <= 0) {
+        cerr << "Bad " << level << " cache: " << size << " bytes in " << ways << " ways, latency "
+            << latency << ", " << mshrs << " MSHRs" << endl;
+        exit(1);
+    }
+
+    Cache::Policy policy = Cache::Policy::LRU;
+    const string& name = configs[prefix + "_policy"];
+    if (name == "srrip")
+        policy = Cache::Policy::SRRIP;
+    else if (name == "drrip")
+        policy = Cache::Policy::DRRIP;
+    else if (name != "" && name != "lru") {
+        cerr << "Unknown " << prefix << "_policy: " << name << endl;
+        exit(1);
+    }
+
+    caches.push_back(new Cache(this, stats, size, ways, latency, mshrs, policy, lower));
+    if (lower)
+        lower->add_higher(caches.back());
+    return caches.back();
+}
+
+bool CacheSystem::send(Request req)
+{
+    Cache* cache = first[req.coreid];
+    if (!cache)
+        return send_memory(req);
+    return cache->send(req);
+}
+
+void CacheSystem::send_later(Cache* lower, const Request& req, int latency)
+{
+    events.push({clk + latency, seq++, false, lower, req});
+}
+
+void CacheSystem::callback_later(const Request& req, int latency)
+{
+    events.push({clk + latency, seq++, true, NULL, req});
+}
+
+bool CacheSystem::deliver(Event& event)
+{
+    if (event.is_callback) {
+        event.req.callback(event.req);
+        return true;
+    }
+    if (event.lower)
+        return event.lower->send(event.req);
+    return send_memory(event.req);
+}
+
+void CacheSystem::tick()
+{
+    clk++;
+    for (size_t n = retries.size(); n > 0; n--) {
+        Event event = retries.front();
+        retries.pop_front();
+        if (!deliver(event))
+            retries.push_back(event);
+    }
+    while (!events.empty() && events.top().clk <= clk) {
+        Event event = events.top();
+        events.pop();
+        if (!deliver(event))
+            retries.push_back(event);
+    }
+}
+
+long CacheSystem::get_idle_cycles() const
+{
+    if (!retries.empty())
+        return 0;
+    if (events.empty())
+        return LONG_MAX;
+    return max(0L, events.top().clk - clk - 1);
+}
+
+long CacheSystem::pending_requests() const
+{
+    long pending = events.size() + retries.size();
+    for (auto cache : caches)
+        pending += cache->mshrs_in_use();
+    return pending;
+}
+
+void CacheSystem::finish(const vector<long>& insts)
+{
+    for (auto level : levels)
+        for (size_t c = 0; c < insts.size(); c++)
+            level->mpki[c] = insts[c] ? level->misses[c].value() * 1000 / insts[c] : 0;
+}
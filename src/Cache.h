@@ -0,0 +1,196 @@
+#ifndef __CACHE_H
+#define __CACHE_H
+
+#include "Config.h"
+#include "Request.h"
+#include "Statistics.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace ramulator
+{
+
+class CacheSystem;
+
+// The stats of a level of the cache hierarchy, per core; the private caches
+// of a level share them
+struct CacheStats
+{
+    std::string level;
+    VectorStat hits;
+    VectorStat misses;
+    VectorStat mpki;
+    ScalarStat mshr_merges;
+    ScalarStat mshr_rejects;
+    ScalarStat writebacks;
+    ScalarStat back_invalidations;
+
+    CacheStats(const std::string& level, int cores);
+};
+
+/* One cache of the hierarchy in cpu mode, between the cores and memory.
+ *
+ * The cache only keeps tags: whether a line is there and whether it is
+ * dirty, not its data. The tags of a set sit next to each other in one
+ * array, a 64-bit word per way with the line address, the dirty bit and the
+ * valid bit, and the replacement state in another, a byte per way, so a
+ * lookup reads a cache line or two even in a cache of many MB.
+ *
+ * Reads that miss take an MSHR and fetch their line from the level below,
+ * after the latency of the tag lookup; further reads and writes to a line
+ * in flight wait in its MSHR and are served when it arrives. Writes are the
+ * writebacks of dirty lines from above, so a write that misses allocates its
+ * line without fetching it, but in a cache that takes the stores of a core
+ * (fetch_writes), a write that misses fetches its line like a read. A dirty
+ * line that is evicted is written back to the level below; an inclusive
+ * cache first drops it from the caches above, and writes it back if any of
+ * them had it dirty.
+ */
+class Cache
+{
+public:
+    enum class Policy {
+        LRU, SRRIP, DRRIP
+    };
+
+    static const int line_bits = 6;
+
+    bool fetch_writes = false;
+    bool inclusive = false;
+
+    // size in bytes, latency in cpu cycles; lower is NULL for memory
+    Cache(CacheSystem* system, CacheStats* stats, long size, int ways, int latency, int mshrs,
+        Policy policy, Cache* lower);
+
+    // Take a request from the level above; a read calls back once its line
+    // is here. False if the request has to wait for an MSHR
+    bool send(Request req);
+
+    // A line fetched from the level below
+    void receive(Request& req);
+
+    // Another cache that sends its misses here
+    void add_higher(Cache* cache) {higher.push_back(cache);}
+
+    // Drop the line from this cache and the ones above it; true if any of
+    // them had it dirty
+    bool invalidate(long line);
+
+    int mshrs_in_use() const {return used_mshrs;}
+
+private:
+    // tags[set * ways + way]: line << 2 | dirty << 1 | valid
+    static const uint64_t valid_bit = 1;
+    static const uint64_t dirty_bit = 2;
+    static const int max_rrpv = 3;
+
+    CacheSystem* system;
+    CacheStats* stats;
+    long sets;
+    int ways;
+    int latency;
+    Policy policy;
+    Cache* lower;
+    std::vector<Cache*> higher;
+
+    std::vector<uint64_t> tags;
+    std::vector<uint8_t> state;  // LRU: rank, 0 is the most recent; RRIP: re-reference prediction
+
+    // DRRIP: set dueling between SRRIP and bimodal RRIP
+    int psel = 512;
+    long brrip_fills = 0;
+
+    struct Mshr {
+        long line = -1;  // -1 when free
+        bool dirty = false;  // a write waits for the line
+        std::vector<Request> reads;
+    };
+    std::vector<Mshr> mshrs;
+    int used_mshrs = 0;
+
+    int find(long set, long line) const;
+    Mshr* find_mshr(long line);
+    void touch(long set, int way);
+    void fill(long line, bool dirty, int coreid);
+    int victim(long set);
+    int leader(long set) const;
+};
+
+/* The caches of a cpu mode run and the clock they tick on, the cpu clock.
+ *
+ * With the config option cache set to L3 or all, the cores share a last
+ * level cache, configured by the options l3_size, l3_ways, l3_latency,
+ * l3_mshrs and l3_policy. With L1L2 or all, each core has an L1 and an L2
+ * of its own in front of it, configured by the same options for l1 and l2,
+ * and the L1 takes the stores of the core. With cache_inclusion set to
+ * inclusive, each level holds the lines of the levels above it.
+ *
+ * The latency of a level passes between the lookup of a request and its hit
+ * calling back or its miss going to the level below, so a read that hits in
+ * the L2 reaches the core after the latencies of the L1 and the L2; requests
+ * that the level below turns down try again every cycle.
+ */
+class CacheSystem
+{
+public:
+    long clk = 0;
+
+    CacheSystem(const Config& configs, int cores, std::function<bool(Request)> send_memory);
+    ~CacheSystem();
+
+    // Where the cores send their requests
+    bool send(Request req);
+
+    // Call at the start of each cpu cycle, before the cores tick
+    void tick();
+
+    // Cycles tick() would have nothing to do in, and skipping them
+    long get_idle_cycles() const;
+    void skip(long cycles) {clk += cycles;}
+
+    // Requests in the caches that memory has not served yet
+    long pending_requests() const;
+
+    // MPKI from the instructions each core retired
+    void finish(const std::vector<long>& insts);
+
+    // Send req to the level below, memory for NULL, or call it back, in
+    // latency cycles
+    void send_later(Cache* lower, const Request& req, int latency);
+    void callback_later(const Request& req, int latency);
+
+private:
+    std::function<bool(Request)> send_memory;
+    std::vector<CacheStats*> levels;
+    std::vector<Cache*> caches;
+    std::vector<Cache*> first;  // the cache each core sends to
+
+    struct Event {
+        long clk;
+        long seq;
+        bool is_callback;
+        Cache* lower;
+        Request req;
+
+        bool operator<(const Event& other) const {
+            return clk != other.clk ? clk > other.clk : seq > other.seq;
+        }
+    };
+    std::priority_queue<Event> events;  // earliest first
+    std::deque<Event> retries;  // turned down by the level below
+    long seq = 0;
+
+    // A cache of the level of stats, e.g. L3, with the options of the level
+    // in the config and the given defaults
+    Cache* add(const Config& configs, CacheStats* stats, long size, int ways, int latency, int mshrs,
+        Cache* lower);
+    bool deliver(Event& event);
+};
+
+} /*namespace ramulator*/
+
+#endif /*__CACHE_H*/
@@ -56,6 +56,14 @@ void Config::parse(const string& fname)
           mem_tick = atoi(tokens[1].c_str());
         }	else if (tokens[0] == "cores_count") {
           cores_count = atoi(tokens[1].c_str());
+        } else if (tokens[0] == "memory_threads") {
+          memory_threads = atoi(tokens[1].c_str());
+        } else if (tokens[0] == "window_depth") {
+          window_depth = atoi(tokens[1].c_str());
+        } else if (tokens[0] == "core_threads") {
+          core_threads = atoi(tokens[1].c_str());
+        } else if (tokens[0] == "core_quantum") {
+          core_quantum = atoi(tokens[1].c_str());
         }
     }
     file.close();
@@ -21,6 +21,10 @@ private:
     int cpu_tick;
     int mem_tick;
 	int cores_count;
+    int memory_threads = 1;
+    int window_depth = 128;
+    int core_threads = 1;
+    int core_quantum = 100;
 
 public:
     Config() {}
@@ -50,6 +54,13 @@ public:
       }
     }
 
+    // Replace an option that is read through operator[], like early_exit
+    void set(const std::string& name, const std::string& value) {
+      options[name] = value;
+    }
+
+    const std::map<std::string, std::string>& get_options() const {return options;}
+
     int get_channels() const {return channels;}
     int get_subarrays() const {return subarrays;}
     int get_ranks() const {return ranks;}
@@ -58,6 +69,10 @@ public:
 	//TODO: each core_tick are currently equal with cpu_tick;
     int get_core_tick(int id) const {return cpu_tick;}
     int get_mem_tick() const {return mem_tick;}
+    int get_memory_threads() const {return memory_threads;}
+    int get_window_depth() const {return window_depth;}
+    int get_core_threads() const {return core_threads;}
+    int get_core_quantum() const {return core_quantum;}
     bool has_l3_cache() const {
       if (options.find("cache") != options.end()) {
         const std::string& cache_option = (options.find("cache"))->second;
@@ -69,8 +84,7 @@ public:
     bool has_core_caches() const {
       if (options.find("cache") != options.end()) {
         const std::string& cache_option = (options.find("cache"))->second;
-          // TODO also includes L1&L2 caches only mode.
-            return (cache_option == "all");
+        return (cache_option == "all") || (cache_option == "L1L2");
       } else {
         return false;
       }
@@ -105,6 +119,64 @@ public:
       }
       return false;
     }
+    bool clock_skipping() const {
+      // the default value is false
+      if (options.find("clock_skipping") != options.end()) {
+        if ((options.find("clock_skipping"))->second == "on") {
+          return true;
+        }
+        return false;
+      }
+      return false;
+    }
+    bool has_trace_generator() const {
+      // the default value is off
+      if (options.find("trace_generator") != options.end()) {
+        return (options.find("trace_generator"))->second != "off";
+      }
+      return false;
+    }
+    bool has_regions() const {
+      // the default value is off
+      if (options.find("regions") != options.end()) {
+        return (options.find("regions"))->second != "off";
+      }
+      return false;
+    }
+    bool has_capture_trace() const {
+      // the default value is off
+      if (options.find("capture_trace") != options.end()) {
+        return (options.find("capture_trace"))->second != "off";
+      }
+      return false;
+    }
+    bool has_trace_timestamps() const {
+      // the default value is off
+      if (options.find("trace_timestamps") != options.end()) {
+        return (options.find("trace_timestamps"))->second != "off";
+      }
+      return false;
+    }
+    bool trace_prefetch() const {
+      // the default value is false
+      if (options.find("trace_prefetch") != options.end()) {
+        if ((options.find("trace_prefetch"))->second == "on") {
+          return true;
+        }
+        return false;
+      }
+      return false;
+    }
+    bool multiprogram_metrics() const {
+      // the default value is false
+      if (options.find("multiprogram_metrics") != options.end()) {
+        if ((options.find("multiprogram_metrics"))->second == "on") {
+          return true;
+        }
+        return false;
+      }
+      return false;
+    }
 };
 
 
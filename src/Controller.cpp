@@ -8,7 +8,7 @@ using namespace ramulator;
 namespace ramulator
 {
 
-static vector<int> get_offending_subarray(DRAM<SALP>* channel, vector<int> & addr_vec){
+static AddrVec get_offending_subarray(DRAM<SALP>* channel, const AddrVec& addr_vec){
     int sa_id = 0;
     auto rank = channel->children[addr_vec[int(SALP::Level::Rank)]];
     auto bank = rank->children[addr_vec[int(SALP::Level::Bank)]];
@@ -18,7 +18,7 @@ static vector<int> get_offending_subarray(DRAM<SALP>* channel, vector<int> & add
             sa_id = sa_other->id;
             break;
         }
-    vector<int> offending = addr_vec;
+    AddrVec offending = addr_vec;
     offending[int(SALP::Level::SubArray)] = sa_id;
     offending[int(SALP::Level::Row)] = -1;
     return offending;
@@ -26,7 +26,7 @@ static vector<int> get_offending_subarray(DRAM<SALP>* channel, vector<int> & add
 
 
 template <>
-vector<int> Controller<SALP>::get_addr_vec(SALP::Command cmd, list<Request>::iterator req){
+AddrVec Controller<SALP>::get_addr_vec(SALP::Command cmd, RequestQueue::iterator req){
     if (cmd == SALP::Command::PRE_OTHER)
         return get_offending_subarray(channel, req->addr_vec);
     else
@@ -34,17 +34,6 @@ vector<int> Controller<SALP>::get_addr_vec(SALP::Command cmd, list<Request>::ite
 }
 
 
-template <>
-bool Controller<SALP>::is_ready(list<Request>::iterator req){
-    SALP::Command cmd = get_first_cmd(req);
-    if (cmd == SALP::Command::PRE_OTHER){
-
-        vector<int> addr_vec = get_offending_subarray(channel, req->addr_vec);
-        return channel->check(cmd, addr_vec.data(), clk);
-    }
-    else return channel->check(cmd, req->addr_vec.data(), clk);
-}
-
 template <>
 void Controller<ALDRAM>::update_temp(ALDRAM::Temp current_temperature){
     channel->spec->aldram_timing(current_temperature);
@@ -60,14 +49,17 @@ void Controller<TLDRAM>::tick(){
 
     /*** 1. Serve completed reads ***/
     if (pending.size()) {
-        Request& req = pending[0];
+        Request& req = pending.front();
         if (req.depart <= clk) {
           if (req.depart - req.arrive > 1) {
                   read_latency_sum += req.depart - req.arrive;
                   channel->update_serving_requests(
                       req.addr_vec.data(), -1, clk);
           }
-            req.callback(req);
+            if (defer_callbacks)
+                served.push_back(req);
+            else
+                req.callback(req);
             pending.pop_front();
         }
     }
@@ -92,11 +84,11 @@ void Controller<TLDRAM>::tick(){
     if (otherq.size())
         queue = &otherq;  // "other" requests are rare, so we give them precedence over reads/writes
 
-    auto req = scheduler->get_head(queue->q);
-    if (req == queue->q.end() || !is_ready(req)) {
+    auto req = scheduler->get_head(*queue);
+    if (req == queue->q.end() || !is_ready(*queue, req)) {
         // we couldn't find a command to schedule -- let's try to be speculative
         auto cmd = TLDRAM::Command::PRE;
-        vector<int> victim = rowpolicy->get_victim(cmd);
+        AddrVec victim = rowpolicy->get_victim(cmd);
         if (!victim.empty()){
             issue_cmd(cmd, victim);
         }
@@ -139,10 +131,11 @@ void Controller<TLDRAM>::tick(){
     /*** 5. Change a read request to a migration request ***/
     if (req->type == Request::Type::READ) {
         req->type = Request::Type::EXTENSION;
+        queue->ready[queue->q.index(req)].decoded = false;
     }
 
     // issue command on behalf of request
-    auto cmd = get_first_cmd(req);
+    auto cmd = get_first_cmd(*queue, req);
     issue_cmd(cmd, get_addr_vec(cmd, req));
 
     // check whether this is the last command (which finishes the request)
@@ -156,6 +149,7 @@ void Controller<TLDRAM>::tick(){
     }
     if (req->type == Request::Type::WRITE) {
         channel->update_serving_requests(req->addr_vec.data(), -1, clk);
+        write_addrs.erase(req->addr);
     }
 
     // remove request from queue
@@ -3,7 +3,6 @@
 
 #include <cassert>
 #include <cstdio>
-#include <deque>
 #include <fstream>
 #include <list>
 #include <string>
@@ -15,6 +14,9 @@
 #include "Request.h"
 #include "Scheduler.h"
 #include "Statistics.h"
+#include "ALDRAM.h"
+#include "SALP.h"
+#include "TLDRAM.h"
 
 using namespace std;
 
@@ -59,16 +61,32 @@ public:
     Refresh<T>* refresh;
 
     struct Queue {
-        list<Request> q;
         unsigned int max = 32;
+        RequestQueue q;
+        // first command of each request and the clock at which it becomes
+        // ready, indexed by slot (see get_first_cmd() and get_ready_clk())
+        struct Readiness {
+            typename T::Command cmd;
+            bool decoded = false;
+            long clk;
+            long issued;  // number of commands issued when clk was computed
+        };
+        vector<Readiness> ready;
         unsigned int size() {return q.size();}
+        Queue() : q(max), ready(max) {}
     };
 
     Queue readq;  // queue for read requests
     Queue writeq;  // queue for write requests
     Queue otherq;  // queue for all "other" requests (e.g., refresh)
-
-    deque<Request> pending;  // read requests that are about to receive data from DRAM
+    AddrCounter write_addrs;  // addresses of the requests in writeq
+
+    RequestPool pool;  // storage for the pending list below
+    RequestList pending;  // read requests that are about to receive data from DRAM
+    // served reads wait here for their callback while the memory ticks the
+    // channels in parallel (see Memory::tick(int))
+    bool defer_callbacks = false;
+    vector<Request> served;
     bool write_mode = false;  // whether write requests should be prioritized over reads
     //long refreshed = 0;  // last time refresh requests were generated
 
@@ -86,6 +104,8 @@ public:
         rowpolicy(new RowPolicy<T>(this)),
         rowtable(new RowTable<T>(this)),
         refresh(new Refresh<T>(this)),
+        write_addrs(writeq.max),
+        pending(PoolAllocator<Request>(&pool)),
         cmd_trace_files(channel->children.size())
     {
         record_cmd_trace = configs.record_cmd_trace();
@@ -244,15 +264,17 @@ public:
             return false;
 
         req.arrive = clk;
-        queue.q.push_back(req);
         // shortcut for read requests, if a write to same addr exists
         // necessary for coherence
-        if (req.type == Request::Type::READ && find_if(writeq.q.begin(), writeq.q.end(),
-                [req](Request& wreq){ return req.addr == wreq.addr;}) != writeq.q.end()){
+        if (req.type == Request::Type::READ && write_addrs.count(req.addr)){
             req.depart = clk + 1;		//ll: write to a same address exists, the read will finished immediately by next clock;
             pending.push_back(req);		//    ? only one clock to read the data from the write queue instead of reading from DRAM?
-            readq.q.pop_back();
+            return true;
         }
+        auto itr = queue.q.push_back(req);
+        queue.ready[queue.q.index(itr)].decoded = false;
+        if (req.type == Request::Type::WRITE)
+            write_addrs.insert(req.addr);
         return true;
     }
 	/* Rq & ll:
@@ -275,7 +297,7 @@ public:
 
         /*** 1. Serve completed reads ***/
         if (pending.size()) {
-            Request& req = pending[0];
+            Request& req = pending.front();
             if (req.depart <= clk) {
                 if (req.depart - req.arrive > 1) { // this request really accessed a row
                   read_latency_sum += req.depart - req.arrive;
@@ -283,7 +305,10 @@ public:
                       req.addr_vec.data(), -1, clk);
                 }
                 // FIXME update req.depart with clk?
-                req.callback(req);
+                if (defer_callbacks)
+                    served.push_back(req);
+                else
+                    req.callback(req);
                 pending.pop_front();
             }
         }
@@ -308,11 +333,11 @@ public:
         if (otherq.size())
             queue = &otherq;  // "other" requests are rare, so we give them precedence over reads/writes
 
-        auto req = scheduler->get_head(queue->q);
-        if (req == queue->q.end() || !is_ready(req)) {
+        auto req = scheduler->get_head(*queue);
+        if (req == queue->q.end() || !is_ready(*queue, req)) {
             // we couldn't find a command to schedule -- let's try to be speculative
             auto cmd = T::Command::PRE;
-            vector<int> victim = rowpolicy->get_victim(cmd);
+            AddrVec victim = rowpolicy->get_victim(cmd);
             if (!victim.empty()){
                 issue_cmd(cmd, victim);// simulate processing the request in the channel.
             }
@@ -353,7 +378,7 @@ public:
         }
 
         // issue command on behalf of request
-        auto cmd = get_first_cmd(req);
+        auto cmd = get_first_cmd(*queue, req);
         issue_cmd(cmd, get_addr_vec(cmd, req));
 
         // check whether this is the last command (which finishes the request)
@@ -368,43 +393,83 @@ public:
 
         if (req->type == Request::Type::WRITE) { // log the statistics
             channel->update_serving_requests(req->addr_vec.data(), -1, clk);
+            write_addrs.erase(req->addr);
         }
 
         // remove request from queue
         queue->q.erase(req);
     }
 
-    bool is_ready(list<Request>::iterator req)
+    // Return the earliest clock at which tick() could do more than tally its
+    // per-cycle statistics: serve a completed read, inject a refresh, switch
+    // the write mode or issue a command
+    long get_next_clk()
     {
-        typename T::Command cmd = get_first_cmd(req);
-        return channel->check(cmd, req->addr_vec.data(), clk);
+        long next_clk = refresh->get_next_clk();
+
+        if (pending.size())
+            next_clk = min(next_clk, pending.front().depart);
+
+        if (!write_mode) {
+            if (writeq.size() >= int(0.8 * writeq.max) || readq.size() == 0)
+                return clk + 1;
+        }
+        else {
+            if (writeq.size() <= int(0.2 * writeq.max) && readq.size() != 0)
+                return clk + 1;
+        }
+
+        Queue* queue = !write_mode ? &readq : &writeq;
+        if (otherq.size())
+            queue = &otherq;
+
+        for (auto req = queue->q.begin(); req != queue->q.end(); req++)
+            next_clk = min(next_clk, get_ready_clk(*queue, req));
+
+        next_clk = min(next_clk, rowpolicy->get_next_clk(T::Command::PRE));
+        return max(next_clk, clk + 1);
     }
 
-    bool is_ready(typename T::Command cmd, const vector<int>& addr_vec)
+    // Fast-forward over cycles in which tick() would have nothing to do
+    void skip(long cycles)
+    {
+        clk += cycles;
+        refresh->clk += cycles;
+        req_queue_length_sum += cycles * (readq.size() + writeq.size());
+        read_req_queue_length_sum += cycles * readq.size();
+        write_req_queue_length_sum += cycles * writeq.size();
+    }
+
+    bool is_ready(Queue& queue, RequestQueue::iterator req)
+    {
+        return get_ready_clk(queue, req) <= clk;
+    }
+
+    bool is_ready(typename T::Command cmd, const AddrVec& addr_vec)
     {
         return channel->check(cmd, addr_vec.data(), clk);
     }
 
-    bool is_row_hit(list<Request>::iterator req)
+    bool is_row_hit(RequestQueue::iterator req)
     {
         // cmd must be decided by the request type, not the first cmd
         typename T::Command cmd = channel->spec->translate[int(req->type)];
         return channel->check_row_hit(cmd, req->addr_vec.data());
     }
 
-    bool is_row_hit(typename T::Command cmd, const vector<int>& addr_vec)
+    bool is_row_hit(typename T::Command cmd, const AddrVec& addr_vec)
     {
         return channel->check_row_hit(cmd, addr_vec.data());
     }
 
-    bool is_row_open(list<Request>::iterator req)
+    bool is_row_open(RequestQueue::iterator req)
     {
         // cmd must be decided by the request type, not the first cmd
         typename T::Command cmd = channel->spec->translate[int(req->type)];
         return channel->check_row_open(cmd, req->addr_vec.data());
     }
 
-    bool is_row_open(typename T::Command cmd, const vector<int>& addr_vec)
+    bool is_row_open(typename T::Command cmd, const AddrVec& addr_vec)
     {
         return channel->check_row_open(cmd, addr_vec.data());
     }
@@ -424,17 +489,63 @@ public:
     }
 
 private:
-    typename T::Command get_first_cmd(list<Request>::iterator req)
+    long issued = 0;  // number of commands issued so far
+
+    typename T::Command get_first_cmd(RequestQueue::iterator req)
     {
         typename T::Command cmd = channel->spec->translate[int(req->type)];
         return channel->decode(cmd, req->addr_vec.data());
     }
 
-    void issue_cmd(typename T::Command cmd, const vector<int>& addr_vec)
+    // The first command of a request only changes with the state of its rank
+    // or bank, so it is decoded again only after a command to either of them
+    typename T::Command get_first_cmd(Queue& queue, RequestQueue::iterator req)
+    {
+        auto& ready = queue.ready[queue.q.index(req)];
+        if (!ready.decoded) {
+            ready.cmd = get_first_cmd(req);
+            ready.decoded = true;
+            ready.issued = -1;
+        }
+        return ready.cmd;
+    }
+
+    // Any command may push back the timings of every node in the channel (e.g.,
+    // through sibling timings between ranks), so the ready clock is looked up
+    // again after each command
+    long get_ready_clk(Queue& queue, RequestQueue::iterator req)
+    {
+        typename T::Command cmd = get_first_cmd(queue, req);
+        auto& ready = queue.ready[queue.q.index(req)];
+        if (ready.issued != issued) {
+            ready.clk = channel->get_next(cmd, get_addr_vec(cmd, req).data());
+            ready.issued = issued;
+        }
+        return ready.clk;
+    }
+
+    // Forget the first command of the queued requests to the ranks and banks
+    // whose state a command may have changed
+    void forget_first_cmds(typename T::Command cmd, const AddrVec& addr_vec)
+    {
+        int scope = min(int(channel->spec->scope[int(cmd)]), int(T::Level::Bank));
+        for (Queue* queue : {&readq, &writeq, &otherq})
+            for (auto req = queue->q.begin(); req != queue->q.end(); req++) {
+                bool overlaps = true;
+                for (int l = int(T::Level::Channel) + 1; l <= scope && overlaps; l++)
+                    overlaps = addr_vec[l] < 0 || req->addr_vec[l] < 0 || addr_vec[l] == req->addr_vec[l];
+                if (overlaps)
+                    queue->ready[queue->q.index(req)].decoded = false;
+            }
+    }
+
+    void issue_cmd(typename T::Command cmd, const AddrVec& addr_vec)
     {
         assert(is_ready(cmd, addr_vec));
         channel->update(cmd, addr_vec.data(), clk);
         rowtable->update(cmd, addr_vec, clk);
+        issued++;
+        forget_first_cmds(cmd, addr_vec);
         if (record_cmd_trace){
             // select rank
             auto& file = cmd_trace_files[addr_vec[1]];
@@ -457,11 +568,16 @@ private:
             printf("\n");
         }
     }
-    vector<int> get_addr_vec(typename T::Command cmd, list<Request>::iterator req){
+    AddrVec get_addr_vec(typename T::Command cmd, RequestQueue::iterator req){
         return req->addr_vec;
     }
 };
 
+// Declaration of specialized member functions, so the compiler knows where to
+// look for these definitions instead of instantiating the generic ones
+template <> AddrVec Controller<SALP>::get_addr_vec(SALP::Command cmd, RequestQueue::iterator req);
+template <> void Controller<TLDRAM>::tick();
+
 } /*namespace ramulator*/
 
 #endif /*__CONTROLLER_H*/
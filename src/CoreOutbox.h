@@ -0,0 +1,52 @@
+#ifndef __COREOUTBOX_H
+#define __COREOUTBOX_H
+
+#include "Request.h"
+#include <deque>
+
+namespace ramulator
+{
+
+// The requests that a core sends while it ticks a quantum of cycles on a
+// thread of its own (core_threads), which reach memory after the quantum.
+// Every request is taken, with the cycle it was sent in, so that the cores'
+// requests can be merged into memory like a serial run sends them: by cycle,
+// then by core. During a quantum only the core's thread pushes, and between
+// quanta only the main thread takes, with the barrier of the worker pool in
+// between, so the queue needs no lock.
+class CoreOutbox
+{
+public:
+    bool send(long clk, const Request& req)
+    {
+        sent.push_back({clk, req});
+        return true;
+    }
+
+    // Hand send() the requests sent up to cycle clk, in order, until it
+    // turns one down; false if it did
+    template <typename Send>
+    bool deliver(long clk, Send& send)
+    {
+        while (!sent.empty() && sent.front().clk <= clk) {
+            if (!send(sent.front().req))
+                return false;
+            sent.pop_front();
+        }
+        return true;
+    }
+
+    bool empty() const {return sent.empty();}
+
+private:
+    struct Sent {
+        long clk;
+        Request req;
+    };
+
+    std::deque<Sent> sent;
+};
+
+} /*namespace ramulator*/
+
+#endif /*__COREOUTBOX_H*/
@@ -103,6 +103,8 @@ public:
         State::MAX, State::PowerUp, State::MAX, State::Closed, State::Closed, State::MAX
     };
 
+    static const int max_open_rows = 1; // rows a bank (or subarray) can hold open at once
+
     /* Translate */
     Command translate[int(Request::Type::MAX)] = {
         Command::RD,  Command::WR,
@@ -110,12 +112,14 @@ public:
     };
 
     /* Prereq */
-    function<Command(DRAM<DDR4>*, Command cmd, int)> prereq[int(Level::MAX)][int(Command::MAX)];
+    static Command prereq(DRAM<DDR4>* node, Command cmd, int id);
 
-    // SAUGATA: added function object container for row hit status
+    // SAUGATA: added row hit status
     /* Row hit */
-    function<bool(DRAM<DDR4>*, Command cmd, int)> rowhit[int(Level::MAX)][int(Command::MAX)];
-    function<bool(DRAM<DDR4>*, Command cmd, int)> rowopen[int(Level::MAX)][int(Command::MAX)];
+    static bool has_rowhit(Level level, Command cmd);
+    static bool rowhit(DRAM<DDR4>* node, Command cmd, int id);
+    static bool has_rowopen(Level level, Command cmd);
+    static bool rowopen(DRAM<DDR4>* node, Command cmd, int id);
 
     /* Timing */
     struct TimingEntry
@@ -126,9 +130,10 @@ public:
         bool sibling;
     }; 
     vector<TimingEntry> timing[int(Level::MAX)][int(Command::MAX)];
+    static const int max_dist = 4; // longest command history looked back on by a TimingEntry
 
     /* Lambda */
-    function<void(DRAM<DDR4>*, int)> lambda[int(Level::MAX)][int(Command::MAX)];
+    static void lambda(DRAM<DDR4>* node, Command cmd, int id);
 
     /* Organization */
     enum class Org : int
@@ -199,13 +204,157 @@ public:
 
 private:
     void init_speed();
-    void init_lambda();
-    void init_prereq();
-    void init_rowhit();  // SAUGATA: added function to check for row hits
-    void init_rowopen();
     void init_timing();
 };
 
+template <> struct has_static_rules<DDR4> : true_type {};
+
+inline DDR4::Command DDR4::prereq(DRAM<DDR4>* node, Command cmd, int id)
+{
+    switch (int(node->level)) {
+        case int(Level::Rank):
+            switch (int(cmd)) {
+                // RD, WR
+                case int(Command::RD):
+                case int(Command::WR):
+                    switch (int(node->state)) {
+                        case int(State::PowerUp): return Command::MAX;
+                        case int(State::ActPowerDown): return Command::PDX;
+                        case int(State::PrePowerDown): return Command::PDX;
+                        case int(State::SelfRefresh): return Command::SRX;
+                        default: assert(false);
+                    }
+                // REF
+                case int(Command::REF):
+                    for (auto bg : node->children)
+                        for (auto bank : bg->children) {
+                            if (bank->state == State::Closed)
+                                continue;
+                            return Command::PREA;
+                        }
+                    return Command::REF;
+                // PD
+                case int(Command::PDE):
+                    switch (int(node->state)) {
+                        case int(State::PowerUp): return Command::PDE;
+                        case int(State::ActPowerDown): return Command::PDE;
+                        case int(State::PrePowerDown): return Command::PDE;
+                        case int(State::SelfRefresh): return Command::SRX;
+                        default: assert(false);
+                    }
+                // SR
+                case int(Command::SRE):
+                    switch (int(node->state)) {
+                        case int(State::PowerUp): return Command::SRE;
+                        case int(State::ActPowerDown): return Command::PDX;
+                        case int(State::PrePowerDown): return Command::PDX;
+                        case int(State::SelfRefresh): return Command::SRE;
+                        default: assert(false);
+                    }
+                default: return Command::MAX;
+            }
+        case int(Level::Bank):
+            switch (int(cmd)) {
+                // RD, WR
+                case int(Command::RD):
+                case int(Command::WR):
+                    switch (int(node->state)) {
+                        case int(State::Closed): return Command::ACT;
+                        case int(State::Opened):
+                            if (node->row_state.is_open(id))
+                                return cmd;
+                            return Command::PRE;
+                        default: assert(false);
+                    }
+                default: return Command::MAX;
+            }
+        default: return Command::MAX;
+    }
+}
+
+// SAUGATA: added row hit check functions to see if the desired location is currently open
+inline bool DDR4::has_rowhit(Level level, Command cmd)
+{
+    return level == Level::Bank && (cmd == Command::RD || cmd == Command::WR);
+}
+
+inline bool DDR4::rowhit(DRAM<DDR4>* node, Command cmd, int id)
+{
+    switch (int(node->state)) {
+        case int(State::Closed): return false;
+        case int(State::Opened):
+            if (node->row_state.is_open(id))
+                return true;
+            return false;
+        default: assert(false);
+    }
+}
+
+inline bool DDR4::has_rowopen(Level level, Command cmd)
+{
+    return level == Level::Bank && (cmd == Command::RD || cmd == Command::WR);
+}
+
+inline bool DDR4::rowopen(DRAM<DDR4>* node, Command cmd, int id)
+{
+    switch (int(node->state)) {
+        case int(State::Closed): return false;
+        case int(State::Opened): return true;
+        default: assert(false);
+    }
+}
+
+inline void DDR4::lambda(DRAM<DDR4>* node, Command cmd, int id)
+{
+    switch (int(node->level)) {
+        case int(Level::Rank):
+            switch (int(cmd)) {
+                case int(Command::PREA):
+                    for (auto bg : node->children)
+                        for (auto bank : bg->children) {
+                            bank->state = State::Closed;
+                            bank->row_state.clear();
+                        }
+                    return;
+                case int(Command::PDE):
+                    for (auto bg : node->children)
+                        for (auto bank : bg->children) {
+                            if (bank->state == State::Closed)
+                                continue;
+                            node->state = State::ActPowerDown;
+                            return;
+                        }
+                    node->state = State::PrePowerDown;
+                    return;
+                case int(Command::PDX):
+                    node->state = State::PowerUp;
+                    return;
+                case int(Command::SRE):
+                    node->state = State::SelfRefresh;
+                    return;
+                case int(Command::SRX):
+                    node->state = State::PowerUp;
+                    return;
+                default: return;
+            }
+        case int(Level::Bank):
+            switch (int(cmd)) {
+                case int(Command::ACT):
+                    node->state = State::Opened;
+                    node->row_state.open(id);
+                    return;
+                case int(Command::PRE):
+                case int(Command::RDA):
+                case int(Command::WRA):
+                    node->state = State::Closed;
+                    node->row_state.clear();
+                    return;
+                default: return;
+            }
+        default: return;
+    }
+}
+
 } /*namespace ramulator*/
 
 #endif /*__DDR4_H*/
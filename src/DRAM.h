@@ -4,7 +4,6 @@
 #include "Statistics.h"
 #include <iostream>
 #include <vector>
-#include <deque>
 #include <map>
 #include <functional>
 #include <algorithm>
@@ -16,6 +15,88 @@ using namespace std;
 namespace ramulator
 {
 
+// A standard that spells out its state machine as static member functions
+// (prereq, rowhit, rowopen and lambda, plus has_rowhit/has_rowopen telling at
+// which level a row hit is decided) specializes this to true_type. DRAM<T>
+// then dispatches to them at compile time, so they can be inlined on the hot
+// path. All other standards go through their std::function lookup tables.
+template <typename T>
+struct has_static_rules : false_type {};
+
+// Timing state of a whole channel, flattened out of the node tree.
+// next[level][cmd] holds one entry per node of that level, indexed by the flat
+// id of the node (its parent's flat id * fanout + its own id). Hence the
+// children of a node are adjacent and updating siblings is a max over a range.
+template <typename T>
+struct FlatTiming
+{
+    vector<long> next[int(T::Level::MAX)][int(T::Command::MAX)];
+    int fanout[int(T::Level::MAX)] = {0}; // number of children per node of a level
+
+    FlatTiming(T* spec, typename T::Level root)
+    {
+        long nodes = 1;
+        for (int l = int(root); l < int(T::Level::Row); l++) {
+            for (int cmd = 0; cmd < int(T::Command::MAX); cmd++)
+                next[l][cmd].resize(nodes, -1); // initialize future
+
+            if (l + 1 == int(T::Level::Row) || !spec->org_entry.count[l + 1])
+                break; // the tree stops here
+            fanout[l] = spec->org_entry.count[l + 1];
+            nodes *= fanout[l];
+        }
+    }
+};
+
+// Fixed-capacity history of the clocks at which a command was issued, most
+// recent first. It is a ring buffer stored inline, so it never allocates.
+template <int N>
+class History
+{
+public:
+    History() {fill_n(clks, N, -1);}
+
+    void push(long clk) {
+        head = (head + N - 1) % N;
+        clks[head] = clk;
+    }
+
+    long operator[](int i) const {return clks[(head + i) % N];}
+
+private:
+    long clks[N];
+    int head = 0;
+};
+
+// Fixed-capacity set of the rows that are open in a bank (or subarray).
+// A handful of slots searched linearly beats a map for the one or two rows
+// that can actually be open, and it never allocates.
+template <int N>
+class OpenRows
+{
+public:
+    bool is_open(int row) const {
+        for (int i = 0; i < n; i++)
+            if (rows[i] == row)
+                return true;
+        return false;
+    }
+
+    void open(int row) {
+        if (is_open(row))
+            return;
+        assert(n < N); // more open rows than the standard allows
+        rows[n++] = row;
+    }
+
+    void clear() {n = 0;}
+    int size() const {return n;}
+
+private:
+    int rows[N];
+    int n = 0;
+};
+
 template <typename T>
 class DRAM
 {
@@ -47,11 +128,8 @@ public:
 
     // State of Rows:
     // There are too many rows for them to be instantiated individually
-    // Instead, their bank (or an equivalent entity) tracks their state for them
-    map<int, typename T::State> row_state;
-
-    // Insert a node as one of my child nodes
-    void insert(DRAM<T>* child);
+    // Instead, their bank (or an equivalent entity) tracks the open ones for them
+    OpenRows<T::max_open_rows> row_state;
 
     // Decode a command into its "prerequisite" command (if any is needed)
     typename T::Command decode(typename T::Command cmd, const int* addr);
@@ -92,11 +170,13 @@ public:
 private:
     // Constructor
     DRAM(){}
+    DRAM(T* spec, typename T::Level level, DRAM* parent, int id);
 
     // Timing
     long cur_clk = 0;
-    long next[int(T::Command::MAX)]; // the earliest time in the future when a command could be ready
-    deque<long> prev[int(T::Command::MAX)]; // the most recent history of when commands were issued
+    FlatTiming<T>* flat; // the earliest time in the future when a command could be ready (owned by the root)
+    long index; // my flat id within my level
+    History<T::max_dist> prev[int(T::Command::MAX)]; // the most recent history of when commands were issued
 
     // Lookup table for which commands must be preceded by which other commands (i.e., "prerequisite")
     // E.g., a read command to a closed bank must be preceded by an activate command
@@ -119,6 +199,47 @@ private:
     // Helper Functions
     void update_state(typename T::Command cmd, const int* addr);
     void update_timing(typename T::Command cmd, const int* addr, long clk);
+    void update_target_timing(typename T::Command cmd, long clk);
+
+    // Dispatch to either the static rules or the lookup tables of the standard
+    void init_rules(true_type) {
+        prereq = NULL;
+        rowhit = rowopen = NULL;
+        lambda = NULL;
+    }
+    void init_rules(false_type) {
+        prereq = spec->prereq[int(level)];
+        rowhit = spec->rowhit[int(level)];
+        rowopen = spec->rowopen[int(level)];
+        lambda = spec->lambda[int(level)];
+    }
+
+    typename T::Command get_prereq(typename T::Command cmd, int id, true_type) {
+        return T::prereq(this, cmd, id);
+    }
+    typename T::Command get_prereq(typename T::Command cmd, int id, false_type) {
+        if (!prereq[int(cmd)])
+            return T::Command::MAX;
+        return prereq[int(cmd)](this, cmd, id);
+    }
+
+    bool has_rowhit(typename T::Command cmd, true_type) {return T::has_rowhit(level, cmd);}
+    bool has_rowhit(typename T::Command cmd, false_type) {return bool(rowhit[int(cmd)]);}
+    bool get_rowhit(typename T::Command cmd, int id, true_type) {return T::rowhit(this, cmd, id);}
+    bool get_rowhit(typename T::Command cmd, int id, false_type) {return rowhit[int(cmd)](this, cmd, id);}
+
+    bool has_rowopen(typename T::Command cmd, true_type) {return T::has_rowopen(level, cmd);}
+    bool has_rowopen(typename T::Command cmd, false_type) {return bool(rowopen[int(cmd)]);}
+    bool get_rowopen(typename T::Command cmd, int id, true_type) {return T::rowopen(this, cmd, id);}
+    bool get_rowopen(typename T::Command cmd, int id, false_type) {return rowopen[int(cmd)](this, cmd, id);}
+
+    void apply_lambda(typename T::Command cmd, int id, true_type) {
+        T::lambda(this, cmd, id);
+    }
+    void apply_lambda(typename T::Command cmd, int id, false_type) {
+        if (lambda[int(cmd)])
+            lambda[int(cmd)](this, id);
+    }
 }; /* class DRAM */
 
 
@@ -186,26 +307,31 @@ void DRAM<T>::finish(int dram_cycles) {
 // Constructor
 template <typename T>
 DRAM<T>::DRAM(T* spec, typename T::Level level) :
-    spec(spec), level(level), id(0), parent(NULL)
+    DRAM(spec, level, NULL, 0)
+{
+}
+
+template <typename T>
+DRAM<T>::DRAM(T* spec, typename T::Level level, DRAM* parent, int id) :
+    spec(spec), level(level), id(id), parent(parent)
 {
 
     state = spec->start[(int)level];
-    prereq = spec->prereq[int(level)];
-    rowhit = spec->rowhit[int(level)];
-    rowopen = spec->rowopen[int(level)];
-    lambda = spec->lambda[int(level)];
+    init_rules(has_static_rules<T>());
     timing = spec->timing[int(level)];
 
-    fill_n(next, int(T::Command::MAX), -1); // initialize future
-    for (int cmd = 0; cmd < int(T::Command::MAX); cmd++) {
-        int dist = 0;
-        for (auto& t : timing[cmd])
-            dist = max(dist, t.dist);
-
-        if (dist)
-            prev[cmd].resize(dist, -1); // initialize history
+    if (parent) {
+        flat = parent->flat;
+        index = parent->index * flat->fanout[int(parent->level)] + id;
+    } else {
+        flat = new FlatTiming<T>(spec, level);
+        index = 0;
     }
 
+    for (int cmd = 0; cmd < int(T::Command::MAX); cmd++)
+        for (auto& t : timing[cmd])
+            assert(t.dist <= T::max_dist); // history must be long enough
+
     // try to recursively construct my children
     int child_level = int(level) + 1;
     if (child_level == int(T::Level::Row))
@@ -217,9 +343,7 @@ DRAM<T>::DRAM(T* spec, typename T::Level level) :
 
     // recursively construct my children
     for (int i = 0; i < child_max; i++) {
-        DRAM<T>* child = new DRAM<T>(spec, typename T::Level(child_level));
-        child->parent = this;
-        child->id = i;
+        DRAM<T>* child = new DRAM<T>(spec, typename T::Level(child_level), this, i);
         children.push_back(child);
     }
 
@@ -230,15 +354,8 @@ DRAM<T>::~DRAM()
 {
     for (auto child: children)
         delete child;
-}
-
-// Insert
-template <typename T>
-void DRAM<T>::insert(DRAM<T>* child)
-{
-    child->parent = this;
-    child->id = children.size();
-    children.push_back(child);
+    if (!parent)
+        delete flat;
 }
 
 // Decode
@@ -246,11 +363,9 @@ template <typename T>
 typename T::Command DRAM<T>::decode(typename T::Command cmd, const int* addr)
 {
     int child_id = addr[int(level)+1];
-    if (prereq[int(cmd)]) {
-        typename T::Command prereq_cmd = prereq[int(cmd)](this, cmd, child_id);
-        if (prereq_cmd != T::Command::MAX)
-            return prereq_cmd; // stop recursion: there is a prerequisite at this level
-    }
+    typename T::Command prereq_cmd = get_prereq(cmd, child_id, has_static_rules<T>());
+    if (prereq_cmd != T::Command::MAX)
+        return prereq_cmd; // stop recursion: there is a prerequisite at this level
 
     if (child_id < 0 || !children.size())
         return cmd; // stop recursion: there were no prequisites at any level
@@ -264,15 +379,20 @@ typename T::Command DRAM<T>::decode(typename T::Command cmd, const int* addr)
 template <typename T>
 bool DRAM<T>::check(typename T::Command cmd, const int* addr, long clk)
 {
-    if (next[int(cmd)] != -1 && clk < next[int(cmd)])
-        return false; // stop recursion: the check failed at this level
-
-    int child_id = addr[int(level)+1];
-    if (child_id < 0 || level == spec->scope[int(cmd)] || !children.size())
-        return true; // stop recursion: the check passed at all levels
-
-    // recursively check my child
-    return children[child_id]->check(cmd, addr, clk);
+    int scope = int(spec->scope[int(cmd)]);
+    long idx = index;
+    for (int l = int(level);; l++) {
+        long next = flat->next[l][int(cmd)][idx];
+        if (next != -1 && clk < next)
+            return false; // the check failed at this level
+
+        int child_id = addr[l+1];
+        if (child_id < 0 || l == scope || !flat->fanout[l])
+            return true; // the check passed at all levels
+
+        // check my child
+        idx = idx * flat->fanout[l] + child_id;
+    }
 }
 
 // SAUGATA: added function to check whether a command is a row hit
@@ -281,8 +401,8 @@ template <typename T>
 bool DRAM<T>::check_row_hit(typename T::Command cmd, const int* addr)
 {
     int child_id = addr[int(level)+1];
-    if (rowhit[int(cmd)]) {
-        return rowhit[int(cmd)](this, cmd, child_id);  // stop recursion: there is a row hit at this level
+    if (has_rowhit(cmd, has_static_rules<T>())) {
+        return get_rowhit(cmd, child_id, has_static_rules<T>());  // stop recursion: there is a row hit at this level
     }
 
     if (child_id < 0 || !children.size())
@@ -296,8 +416,8 @@ template <typename T>
 bool DRAM<T>::check_row_open(typename T::Command cmd, const int* addr)
 {
     int child_id = addr[int(level)+1];
-    if (rowopen[int(cmd)]) {
-        return rowopen[int(cmd)](this, cmd, child_id);  // stop recursion: there is a row hit at this level
+    if (has_rowopen(cmd, has_static_rules<T>())) {
+        return get_rowopen(cmd, child_id, has_static_rules<T>());  // stop recursion: there is a row hit at this level
     }
 
     if (child_id < 0 || !children.size())
@@ -310,11 +430,11 @@ bool DRAM<T>::check_row_open(typename T::Command cmd, const int* addr)
 template <typename T>
 long DRAM<T>::get_next(typename T::Command cmd, const int* addr)
 {
-    long next_clk = max(cur_clk, next[int(cmd)]);
-    auto node = this;
-    for (int l = int(level); l < int(spec->scope[int(cmd)]) && node->children.size() && addr[l + 1] >= 0; l++){
-        node = node->children[addr[l + 1]];
-        next_clk = max(next_clk, node->next[int(cmd)]);
+    long idx = index;
+    long next_clk = max(cur_clk, flat->next[int(level)][int(cmd)][idx]);
+    for (int l = int(level); l < int(spec->scope[int(cmd)]) && flat->fanout[l] && addr[l + 1] >= 0; l++){
+        idx = idx * flat->fanout[l] + addr[l + 1];
+        next_clk = max(next_clk, flat->next[l + 1][int(cmd)][idx]);
     }
     return next_clk;
 }
@@ -334,8 +454,7 @@ template <typename T>
 void DRAM<T>::update_state(typename T::Command cmd, const int* addr)
 {
     int child_id = addr[int(level)+1];
-    if (lambda[int(cmd)])
-        lambda[int(cmd)](this, child_id); // update this level
+    apply_lambda(cmd, child_id, has_static_rules<T>()); // update this level
 
     if (level == spec->scope[int(cmd)] || !children.size())
         return; // stop recursion: updated all levels
@@ -349,26 +468,51 @@ void DRAM<T>::update_state(typename T::Command cmd, const int* addr)
 template <typename T>
 void DRAM<T>::update_timing(typename T::Command cmd, const int* addr, long clk)
 {
-    // I am not a target node: I am merely one of its siblings
-    if (id != addr[int(level)]) {
-        for (auto& t : timing[int(cmd)]) {
+    assert(id == addr[int(level)]);
+
+    // Some commands have timings that are higher that their scope levels, thus
+    // we do not stop at the cmd's scope level
+    DRAM<T>* node = this;
+    while (true) {
+        node->update_target_timing(cmd, clk);
+        if (!node->children.size())
+            return; // updated all levels
+
+        // All my children but the next target are merely its siblings
+        int l = int(node->level) + 1;
+        int child_id = addr[l];
+        long first = node->index * flat->fanout[l-1];
+        long last = first + node->children.size();
+        for (auto& t : spec->timing[l][int(cmd)]) {
             if (!t.sibling)
                 continue; // not an applicable timing parameter
 
             assert (t.dist == 1);
 
             long future = clk + t.val;
-            next[int(t.cmd)] = max(next[int(t.cmd)], future); // update future
+            long* next = flat->next[l][int(t.cmd)].data();
+            if (child_id < 0) {
+                for (long i = first; i < last; i++)
+                    next[i] = max(next[i], future); // update future
+                continue;
+            }
+            for (long i = first; i < first + child_id; i++)
+                next[i] = max(next[i], future);
+            for (long i = first + child_id + 1; i < last; i++)
+                next[i] = max(next[i], future);
         }
 
-        return; // stop recursion: only target nodes should be recursed
+        if (child_id < 0)
+            return; // there is no target further down
+        node = node->children[child_id];
     }
+}
 
-    // I am a target node
-    if (prev[int(cmd)].size()) {
-        prev[int(cmd)].pop_back();  // FIXME TIANSHI why pop back?
-        prev[int(cmd)].push_front(clk); // update history
-    }
+// Update (Timing) of a node that is targeted by a command
+template <typename T>
+void DRAM<T>::update_target_timing(typename T::Command cmd, long clk)
+{
+    prev[int(cmd)].push(clk); // update history
 
     for (auto& t : timing[int(cmd)]) {
         if (t.sibling)
@@ -378,29 +522,20 @@ void DRAM<T>::update_timing(typename T::Command cmd, const int* addr, long clk)
         if (past < 0)
             continue; // not enough history
 
+        long& next = flat->next[int(level)][int(t.cmd)][index];
         long future = past + t.val;
-        next[int(t.cmd)] = max(next[int(t.cmd)], future); // update future
+        next = max(next, future); // update future
         // TIANSHI: for refresh statistics
         if (spec->is_refreshing(cmd) && spec->is_opening(t.cmd)) {
           assert(past == clk);
           begin_of_refreshing = clk;
-          end_of_refreshing = max(end_of_refreshing, next[int(t.cmd)]);
+          end_of_refreshing = max(end_of_refreshing, next);
           refresh_cycles += end_of_refreshing - clk;
           if (cur_serving_requests > 0) {
             refresh_intervals.push_back(make_pair(begin_of_refreshing, end_of_refreshing));
           }
         }
     }
-
-    // Some commands have timings that are higher that their scope levels, thus
-    // we do not stop at the cmd's scope level
-    if (!children.size())
-        return; // stop recursion: updated all levels
-
-    // recursively update *all* of my children
-    for (auto child : children)
-        child->update_timing(cmd, addr, clk);
-
 }
 
 /*
@@ -142,7 +142,7 @@ void DSARP::init_prereq()
       case int(State::Closed): return Command::ACT;
       case int(State::Opened):
         // Really is the subarray state. If the subarray matches, check the row ID
-        if (node->row_state.find(id) != node->row_state.end())
+        if (node->row_state.is_open(id))
           return Command::MAX;
         return Command::PRE;
       default: assert(false);
@@ -153,7 +153,7 @@ void DSARP::init_prereq()
       case int(State::Closed): return Command::ACT;
       case int(State::Opened):
         // Actual row state
-        if (node->row_state.find(id) != node->row_state.end())
+        if (node->row_state.is_open(id))
           return cmd;
         return Command::PRE;
       default: assert(false);
@@ -207,7 +207,7 @@ void DSARP::init_rowhit()
       switch (int(node->state)){
           case int(State::Closed): return false;
           case int(State::Opened):
-              if (node->row_state.find(id) != node->row_state.end()) return true;
+              if (node->row_state.is_open(id)) return true;
               else return false;
           default: assert(false);
       }};
@@ -260,10 +260,10 @@ void DSARP::init_lambda()
   // Open a row
   lambda[int(Level::Bank)][int(Command::ACT)] = [] (DRAM<DSARP>* node, int id) {
     node->state = State::Opened;
-    node->row_state[id] = State::Opened;};
+    node->row_state.open(id);};
   lambda[int(Level::SubArray)][int(Command::ACT)] = [] (DRAM<DSARP>* node, int id) {
     node->state = State::Opened;
-    node->row_state[id] = State::Opened;};
+    node->row_state.open(id);};
 
   // Close a bank
   lambda[int(Level::Bank)][int(Command::PRE)] = [] (DRAM<DSARP>* node, int id) {
@@ -150,6 +150,8 @@ public:
         State::MAX, State::PowerUp, State::Closed, State::Closed, State::MAX
     };
 
+    static const int max_open_rows = 1; // rows a bank (or subarray) can hold open at once
+
     /* Translate */
     Command translate[int(Request::Type::MAX)] = {
         Command::RD,  Command::WR,
@@ -173,6 +175,7 @@ public:
         bool sibling;
     };
     vector<TimingEntry> timing[int(Level::MAX)][int(Command::MAX)];
+    static const int max_dist = 4; // longest command history looked back on by a TimingEntry
 
     /* Lambda */
     function<void(DRAM<DSARP>*, int)> lambda[int(Level::MAX)][int(Command::MAX)];
@@ -1,5 +1,10 @@
 #include "Processor.h"
+#include "Cache.h"
 #include "Config.h"
+#include "CoreOutbox.h"
+#include "MultiprogramMetrics.h"
+#include "RegionSampler.h"
+#include "ReplayQueue.h"
 #include "Controller.h"
 #include "SpeedyController.h"
 #include "Memory.h"
@@ -11,6 +16,7 @@
 #include <stdlib.h>
 #include <functional>
 #include <map>
+#include <new>
 
 /* Standards */
 #include "Gem5Wrapper.h"
@@ -30,11 +36,86 @@
 using namespace std;
 using namespace ramulator;
 
+// Count heap allocations, so that Memory can report them per request. The
+// memory comes from malloc() like in the default operator new, so the default
+// operator delete still releases it. (noinline keeps the compiler from pairing
+// the malloc() with operator delete.)
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    ++heap_allocations();
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+/*
+ * replay a timed dram trace open loop: each request arrives at the cycle of
+ * its timestamp and waits in the frontend until memory takes it.
+ */
+template<typename T>
+void replay_dramtrace(const Config& configs, Memory<T, Controller>& memory, Trace& trace) {
+
+    ReplayQueue frontend(configs, memory.ctrls.size(), memory.tx_bits, memory.clk_ns(), trace.timestamps_in_ns());
+    long clks = 0, time = 0, addr = 0, arrive = 0;
+    int coreid = 0;
+    Request::Type type = Request::Type::READ;
+    map<int, int> latencies;
+    auto read_complete = [&latencies](Request& r){latencies[r.depart - r.arrive]++;};
+
+    Request req(addr, type, Callback(&read_complete));
+    auto send = [&memory](Request& r){return memory.send(r);};
+    bool clock_skipping = configs.clock_skipping();
+
+    bool end = !trace.get_timed_request(time, addr, type, coreid);
+    arrive = frontend.arrival(time);
+    while (!end || !frontend.empty() || memory.pending_requests()){
+        // all that are due arrive, then memory takes what it can
+        while (!end && arrive <= clks){
+            req.addr = addr;
+            req.type = type;
+            req.coreid = coreid;
+            frontend.push(req, memory.get_channel(addr), arrive);
+            end = !trace.get_timed_request(time, addr, type, coreid);
+            arrive = frontend.arrival(time);
+        }
+        frontend.send(clks, send);
+
+        // jump to the next cycle in which a controller has something to do,
+        // or a request arrives
+        if (clock_skipping && memory.pending_requests()) {
+            long idle = memory.get_idle_cycles();
+            if (!end)
+                idle = min(idle, arrive - clks - 1);
+            if (idle > 0) {
+                memory.skip(idle);
+                clks += idle;
+                Stats::curTick += idle;
+            }
+        }
+        memory.tick();
+        clks ++;
+        Stats::curTick++; // memory clock, global, for Statistics
+    }
+    // This a workaround for statistics set only initially lost in the end
+    memory.finish();
+    frontend.finish();
+    Stats::statlist.printall();
+}
+
 template<typename T>
 void run_dramtrace(const Config& configs, Memory<T, Controller>& memory, const char* tracename) {
 
     /* initialize DRAM trace */
-    Trace trace(tracename);
+    Trace trace(configs, tracename);
+    // a timed trace (see TraceCapture and trace_timestamps) is replayed at
+    // the cycles of its requests
+    bool timed = trace.is_timed();
+    if (configs.trace_prefetch())
+        trace.prefetch(timed ? TraceHeader::Kind::Timed : TraceHeader::Kind::DRAM);
+    if (timed) {
+        replay_dramtrace(configs, memory, trace);
+        return;
+    }
 
     /* run simulation */
     bool stall = false, end = false;
@@ -44,7 +125,8 @@ void run_dramtrace(const Config& configs, Memory<T, Controller>& memory, const c
     map<int, int> latencies;
     auto read_complete = [&latencies](Request& r){latencies[r.depart - r.arrive]++;};
 
-    Request req(addr, type, read_complete);
+    Request req(addr, type, Callback(&read_complete));
+    bool clock_skipping = configs.clock_skipping();
 
     while (!end || memory.pending_requests()){
         if (!end && !stall){
@@ -60,6 +142,17 @@ void run_dramtrace(const Config& configs, Memory<T, Controller>& memory, const c
                 else if (type == Request::Type::WRITE) writes++;
             }
         }
+
+        // nothing new can be sent until a controller makes progress: jump
+        // straight to the next cycle in which one has something to do
+        if (clock_skipping && (end || stall) && memory.pending_requests()) {
+            long idle = memory.get_idle_cycles();
+            if (idle > 0) {
+                memory.skip(idle);
+                clks += idle;
+                Stats::curTick += idle;
+            }
+        }
         memory.tick();
         clks ++;
         Stats::curTick++; // memory clock, global, for Statistics
@@ -92,40 +185,135 @@ void run_cputrace(const Config& configs, Memory<T, Controller>& memory, const ch
     //  first parameter fixed to &memory and second parameter left undetermined.
     //  send function can be called like 'send(parameter2);' where parameter2 will fill the placeholder _1.
     
-    auto send = bind(&Memory<T, Controller>::send, &memory, placeholders::_1);
+    function<bool(Request)> send = bind(&Memory<T, Controller>::send, &memory, placeholders::_1);
+    // with caches, the core sends to them and they send their misses to memory
+    CacheSystem* caches = NULL;
+    if (configs.has_l3_cache() || configs.has_core_caches()) {
+        caches = new CacheSystem(configs, 1, send);
+        send = bind(&CacheSystem::send, caches, placeholders::_1);
+    }
     // create Processor using <configs, trace filename, send function);>
     //  matching constructor Processor(const Config& configs, const char* trace_fname, function<bool(Request)> send)
     Processor proc(configs, file, send);
     //Processor proc0(configs, file, send);
     //Processor proc1(configs, file, send);
+    bool clock_skipping = configs.clock_skipping();
+    // simulate only the regions of the trace in the region file, if any
+    RegionSampler* sampler = NULL;
+    if (configs.has_regions())
+        sampler = new RegionSampler(configs, {&proc},
+            memory.spec->speed_entry.tCK * mem_tick / cpu_tick, 1 << memory.tx_bits);
     for (long i = 0; ; i++) {
+        if (caches)
+            caches->tick();
         proc.tick(); //
         //proc0.tick(); //
         //proc1.tick(); //
         Stats::curTick++; // processor clock, global, for Statistics
         if (i % cpu_tick == (cpu_tick - 1)) // do this branch every 4(=cpu_tick) cpu cycles, but why (cpu_tick-1) instead of cpu_tick
-            for (int j = 0; j < mem_tick; j++)// ? what relation: cpu_tick v.s. mem_tick; why do 1 mem per 4 cpu ticks?(1=mem_tick, 4=cpu_tick)
-                memory.tick();
+            memory.tick(mem_tick);// ? what relation: cpu_tick v.s. mem_tick; why do 1 mem per 4 cpu ticks?(1=mem_tick, 4=cpu_tick)
+      if (sampler) {
+        sampler->tick();
+        if (sampler->done())
+            break;
+      }
       if (configs.is_early_exit()) {
         if (proc.finished())
             break;
       } else {
-        if (proc.finished() && (memory.pending_requests() == 0))
+        if (proc.finished() && (memory.pending_requests() == 0)
+                && (!caches || caches->pending_requests() == 0))
             break;
       }
+      // the core waits on memory: skip whole cpu_tick periods in which
+      // the memory and the caches have nothing to do either
+      if (clock_skipping && i % cpu_tick == (cpu_tick - 1) && proc.is_stalled()) {
+        long periods = memory.get_idle_cycles() / mem_tick;
+        if (caches)
+          periods = min(periods, caches->get_idle_cycles() / cpu_tick);
+        if (periods > 0) {
+          proc.skip(periods * cpu_tick);
+          memory.skip(periods * mem_tick);
+          if (caches)
+            caches->skip(periods * cpu_tick);
+          Stats::curTick += periods * cpu_tick;
+          i += periods * cpu_tick;
+        }
+      }
     }
     // This a workaround for statistics set only initially lost in the end
     memory.finish();
+    if (caches)
+        caches->finish({proc.retired});
+    if (sampler)
+        sampler->finish();
     Stats::statlist.printall();
+    delete sampler;
+    delete caches;
 }
 
 #ifdef __ENABLE_MULTICORES
 
+/*
+ * tick the cores a quantum of cpu cycles at a time, in parallel on the threads
+ * of a pool, and then the caches and memory through the same cycles, with the
+ * requests that the cores sent merged in by cycle and core. Reads served in a
+ * quantum only reach their core in the next one, which is what the parallel
+ * run trades for its speed; the results only depend on core_quantum, not on
+ * the number of threads.
+ */
+template <typename T>
+void run_core_quanta(const Config& configs, Memory<T, Controller>& memory, CacheSystem* caches,
+        std::vector<Processor*>& cores, std::vector<CoreOutbox>& outboxes,
+        ScalarStat& cpu_cycles_main, VectorStat& core_cycles_main)
+{
+    int cpu_tick = configs.get_cpu_tick();
+    int mem_tick = configs.get_mem_tick();
+    // whole memory periods, so that memory ticks in the cycles of a serial run
+    long quantum = max(1, (configs.get_core_quantum() + cpu_tick - 1) / cpu_tick) * cpu_tick;
+    WorkerPool pool(min(configs.get_core_threads(), int(cores.size())));
+    printf("ticking %zu cores on %d threads in quanta of %ld cpu cycles\n", cores.size(), pool.size(), quantum);
+
+    auto tick_core = [&cores, quantum] (int c) {
+        for (long j = 0; j < quantum; j++)
+            cores[c]->tick();
+    };
+    auto send = [&memory, caches] (Request& req) {return caches ? caches->send(req) : memory.send(req);};
+
+    for (long i = 0; ; i += quantum) {
+        pool.run(cores.size(), tick_core);
+
+        for (long j = i; j < i + quantum; j++) {
+            if (caches)
+                caches->tick();
+            // a core that is turned down sends nothing newer, like a stalled
+            // core in a serial run; cores count clk from 1
+            for (unsigned int c = 0; c < cores.size(); c++)
+                outboxes[c].deliver(j + 1, send);
+            Stats::curTick++; // processor clock, global, for Statistics
+            if (j % cpu_tick == cpu_tick - 1)
+                memory.tick(mem_tick);
+        }
+        for (auto core : cores) {
+            core_cycles_main[core->getID()] += quantum;
+            cpu_cycles_main += quantum;
+        }
+
+        bool all_finished = true;
+        for (unsigned int c = 0; c < cores.size(); c++)
+            all_finished = all_finished && cores[c]->finished() && outboxes[c].empty();
+        if (all_finished && (configs.is_early_exit()
+                || (memory.pending_requests() == 0 && (!caches || caches->pending_requests() == 0))))
+            break;
+    }
+}
+
 template <typename T>
 void run_cputraces(const Config& configs, 
 							Memory<T, Controller>& memory, 
 							std::vector <const char *> files, 
-							int filesCount)
+							int filesCount,
+							MultiprogramMetrics* metrics)
 {
 	
 	if(filesCount<2){ 
@@ -144,6 +332,7 @@ void run_cputraces(const Config& configs,
 	
 	//printf("lele:in %s: cpu_tick= %d.\t mem_tick=%d\n",__PRETTY_FUNCTION__,cpu_tick,mem_tick);
 	printf("lele:in %s: cpu_tick= %d.\t mem_tick=%d\n",__FUNCTION__,cpu_tick,mem_tick);
+    bool clock_skipping = configs.clock_skipping();
 
 
 	
@@ -153,7 +342,13 @@ void run_cputraces(const Config& configs,
     //  first parameter fixed to &memory and second parameter left undetermined.
     //  send function can be called like 'send(parameter2);' where parameter2 will fill the placeholder _1.
     
-    auto send = bind(&Memory<T, Controller>::send, &memory, placeholders::_1);
+    function<bool(Request)> send = bind(&Memory<T, Controller>::send, &memory, placeholders::_1);
+    // with caches, the cores send to them and they send their misses to memory
+    CacheSystem* caches = NULL;
+    if (configs.has_l3_cache() || configs.has_core_caches()) {
+        caches = new CacheSystem(configs, min(coresCount, filesCount), send);
+        send = bind(&CacheSystem::send, caches, placeholders::_1);
+    }
 
 	// for test:
 		// add counters for cpu and per-core ticks here for comparing and verification
@@ -180,16 +375,36 @@ void run_cputraces(const Config& configs,
     //Processor proc0(configs, file, send);
     //Processor proc1(configs, file, send);
     std::vector<Processor*> cores;
+
+    // with core_threads, the cores tick in quanta on threads of their own and
+    // their requests wait in outboxes until memory catches up; regions and
+    // clock skipping keep the serial loop
+    bool parallel = configs.get_core_threads() > 1 && !configs.has_regions() && !clock_skipping;
+    std::vector<CoreOutbox> outboxes(parallel ? min(coresCount, filesCount) : 0);
      
     for (int id=0;id<coresCount && id<filesCount;id++){
 		// TODO: now only simple schedule: one file for one core and no core can run two files.
-		Processor* proc = new Processor(configs,files[id], send, id);
+		function<bool(Request)> core_send = send;
+		if (parallel)
+			core_send = [&outboxes, &cores, id] (Request req) {return outboxes[id].send(cores[id]->clk, req);};
+		Processor* proc = new Processor(configs,files[id], core_send, id);
 	    cores.push_back(proc);
 		printf("lele: create core %d, running file %s\n",id,files[id]);
 	}
 
-	
-    for (long i = 0; ; i++) {
+    // simulate only the regions of the traces in the region file, if any
+    RegionSampler* sampler = NULL;
+    if (configs.has_regions())
+        sampler = new RegionSampler(configs, cores,
+            memory.spec->speed_entry.tCK * mem_tick / cpu_tick, 1 << memory.tx_bits);
+
+
+    if (parallel)
+        run_core_quanta(configs, memory, caches, cores, outboxes, cpu_cycles_main, core_cycles_main);
+
+    for (long i = 0; !parallel; i++) {
+        if (caches)
+            caches->tick();
         //proc.tick(); 
         for (auto core : cores) {
           core->tick();
@@ -200,8 +415,12 @@ void run_cputraces(const Config& configs,
         }	
         Stats::curTick++; // processor clock, global, for Statistics
         if (i % cpu_tick == (cpu_tick - 1)) // do this branch every 4(=cpu_tick) cpu cycles, but why (cpu_tick-1) instead of cpu_tick
-            for (int j = 0; j < mem_tick; j++)// ? what relation: cpu_tick v.s. mem_tick; why do 1 mem per 4 cpu ticks?(1=mem_tick, 4=cpu_tick)
-                memory.tick();
+            memory.tick(mem_tick);// ? what relation: cpu_tick v.s. mem_tick; why do 1 mem per 4 cpu ticks?(1=mem_tick, 4=cpu_tick)
+      if (sampler) {
+        sampler->tick();
+        if (sampler->done())
+            break;
+      }
       if (configs.is_early_exit()) {
         // TODO LELE: use all_finished to simulate this.
 
@@ -231,12 +450,57 @@ void run_cputraces(const Config& configs,
 		  	break;
 		  }
         }	
-        if (all_finished && (memory.pending_requests() == 0)) break; 
+        if (all_finished && (memory.pending_requests() == 0)
+                && (!caches || caches->pending_requests() == 0)) break; 
+      }
+      // all cores wait on memory: skip whole cpu_tick periods in which
+      // the memory and the caches have nothing to do either
+      if (clock_skipping && i % cpu_tick == (cpu_tick - 1)) {
+        bool all_stalled = true;
+        for (auto core : cores) {
+          if (!core->is_stalled()) {
+            all_stalled = false;
+            break;
+          }
+        }
+        long periods = all_stalled ? memory.get_idle_cycles() / mem_tick : 0;
+        if (caches)
+          periods = min(periods, caches->get_idle_cycles() / cpu_tick);
+        if (periods > 0) {
+          for (auto core : cores) {
+            core->skip(periods * cpu_tick);
+            core_cycles_main[core->getID()] += periods * cpu_tick;
+            cpu_cycles_main += periods * cpu_tick;
+          }
+          memory.skip(periods * mem_tick);
+          if (caches)
+            caches->skip(periods * cpu_tick);
+          Stats::curTick += periods * cpu_tick;
+          i += periods * cpu_tick;
+        }
       }
     }
     // This a workaround for statistics set only initially lost in the end
     memory.finish();
+    if (caches) {
+        std::vector<long> insts;
+        for (auto core : cores)
+            insts.push_back(core->retired);
+        caches->finish(insts);
+    }
+    if (metrics) {
+        std::vector<long> insts, cycles;
+        for (auto core : cores) {
+            insts.push_back(core->fetched);
+            cycles.push_back(core->finished_clk ? core->finished_clk : core->clk);
+        }
+        metrics->finish(insts, cycles);
+    }
+    if (sampler)
+        sampler->finish();
     Stats::statlist.printall();
+    delete sampler;
+    delete caches;
 }
 
 
@@ -252,7 +516,8 @@ void run_cputraces(const Config& configs,
  *
  */
 template<typename T>
-void start_run(const Config& configs, T* spec, std::vector <const char*> files, int filesCount) {
+void start_run(const Config& configs, T* spec, std::vector <const char*> files, int filesCount,
+        MultiprogramMetrics* metrics = NULL) {
   // initiate controller and memory
   int C = configs.get_channels(), R = configs.get_ranks();
   // Check and Set channel, rank number
@@ -271,7 +536,7 @@ void start_run(const Config& configs, T* spec, std::vector <const char*> files,
   if (configs["trace_type"] == "MULTICORES") {
   	printf("lele: in %s, multicores mode\n",__FUNCTION__);
 	//printf("lele: in %s,\n",__PRETTY_FUNCTION__);
-    run_cputraces(configs, memory, files,filesCount);
+    run_cputraces(configs, memory, files,filesCount, metrics);
   } else if (configs["trace_type"] == "DRAM") {
     //run_dramtrace(configs, memory, file);
     printf("TODO: run dram trace not implemented yet.\n");
@@ -321,9 +586,33 @@ int main(int argc, const char *argv[])
 {
     if (argc < 2) {
         printf("Usage: %s <configs-file> --mode=cpu,dram,multicore [--stats <filename>] <trace-filename>\n"
-            "Example: %s ramulator-configs.cfg cpu.trace\n", argv[0], argv[0]);
+            "       (the trace-filename can be left out when the config sets trace_generator)\n"
+            "       %s --convert-trace=cpu,dram <text-trace-filename> <binary-trace-filename>\n"
+            "       %s --index-trace=cpu,dram <trace-filename> [<records-between-checkpoints>]\n"
+            "Example: %s ramulator-configs.cfg cpu.trace\n", argv[0], argv[0], argv[0], argv[0]);
         return 0;
     }
+
+    // convert a text trace to the binary format, which is read much faster
+    if (strncmp(argv[1], "--convert-trace=", 16) == 0) {
+        const char* kind = argv[1] + 16;
+        if (argc != 4 || (strcmp(kind, "cpu") != 0 && strcmp(kind, "dram") != 0)) {
+            printf("Usage: %s --convert-trace=cpu,dram <text-trace-filename> <binary-trace-filename>\n", argv[0]);
+            return 1;
+        }
+        return Trace::convert(argv[2], argv[3], strcmp(kind, "dram") == 0) ? 0 : 1;
+    }
+
+    // write <trace-filename>.idx, to start reading the trace anywhere
+    if (strncmp(argv[1], "--index-trace=", 14) == 0) {
+        const char* kind = argv[1] + 14;
+        long interval = argc == 4 ? atol(argv[3]) : TraceIndex::default_interval;
+        if (argc < 3 || argc > 4 || interval <= 0 || (strcmp(kind, "cpu") != 0 && strcmp(kind, "dram") != 0)) {
+            printf("Usage: %s --index-trace=cpu,dram <trace-filename> [<records-between-checkpoints>]\n", argv[0]);
+            return 1;
+        }
+        return Trace::build_index(argv[2], strcmp(kind, "dram") == 0, interval) ? 0 : 1;
+    }
     printf("number of arg: argc:%d\n",argc);
 
 	bool enable_multicores=false;
@@ -357,7 +646,7 @@ int main(int argc, const char *argv[])
     string stats_out;
 	
 	// parse the output file name
-    if (strcmp(argv[3], "--stats") == 0) {
+    if (argc > 4 && strcmp(argv[3], "--stats") == 0) {
       Stats::statlist.output(argv[4]);
       stats_out = argv[4];
       trace_start = 5;
@@ -371,8 +660,11 @@ int main(int argc, const char *argv[])
     std::vector <const char*> files;
 	
 	int filesCount=0;
+	// a generated trace needs no file, it is named after its pattern
+	string generator_name = "generator:" + configs["trace_generator"];
+	bool generated = configs.has_trace_generator() && trace_start >= argc;
 	if(!enable_multicores){
-	  file = argv[trace_start];
+	  file = generated ? generator_name.c_str() : argv[trace_start];
 	}else{
 	  printf("lele: multicore enabled\n");
 	  filesCount=0;
@@ -383,6 +675,8 @@ int main(int argc, const char *argv[])
 		printf("trace file[%d]: %s\n",filesCount,files[filesCount]);
   		filesCount++;
 	  }
+	  for(; generated && filesCount<configs.get_cores_count(); filesCount++)
+		files.push_back(generator_name.c_str());
 	}
 	//return 0;
 	/* 1) parse the standard name, 
@@ -396,7 +690,17 @@ int main(int argc, const char *argv[])
 	  
 	  if(enable_multicores){
 	  	printf("lele: in %s: start_run multicore simulation.\n",__PRETTY_FUNCTION__);
-      	start_run(configs, ddr3, files,filesCount);
+	  	// run the trace of each core alone too, to compare the mix against
+	  	MultiprogramMetrics* metrics = NULL;
+	  	if (configs.multiprogram_metrics()) {
+	  	  std::vector<const char*> mix(files.begin(), files.begin() + min(filesCount, configs.get_cores_count()));
+	  	  metrics = new MultiprogramMetrics(configs, mix, [] (const Config& alone_configs, const char* alone_file) {
+	  	    start_run(alone_configs, new DDR3(alone_configs["org"], alone_configs["speed"]), alone_file);
+	  	  });
+	  	  metrics->start();
+	  	}
+      	start_run(configs, ddr3, files,filesCount, metrics);
+      	delete metrics;
 	  }else{
 	  	printf("lele: in %s: start_run singlecore simulation.\n",__PRETTY_FUNCTION__);
 	  	start_run(configs, ddr3, file);
@@ -7,23 +7,37 @@
 #include "Controller.h"
 #include "SpeedyController.h"
 #include "Statistics.h"
+#include "TraceCapture.h"
 #include "GDDR5.h"
 #include "HBM.h"
 #include "LPDDR3.h"
 #include "LPDDR4.h"
 #include "WideIO2.h"
 #include "DSARP.h"
+#include "WorkerPool.h"
 #include <vector>
 #include <functional>
 #include <cmath>
 #include <cassert>
 #include <tuple>
+#include <limits>
+#include <type_traits>
+#include <atomic>
 
 using namespace std;
 
 namespace ramulator
 {
 
+// Number of heap allocations made so far. The standalone simulator counts
+// them in its operator new (see Main.cpp); elsewhere it stays at zero. It is
+// atomic because the channels may tick on worker threads.
+inline atomic<long>& heap_allocations()
+{
+    static atomic<long> count{0};
+    return count;
+}
+
 class MemoryBase{
 public:
     MemoryBase() {}
@@ -57,7 +71,25 @@ protected:
   ScalarStat in_queue_read_req_num_avg;
   ScalarStat in_queue_write_req_num_avg;
 
+  ScalarStat num_heap_allocations;
+  ScalarStat heap_allocations_per_request;
+
   long max_address;
+  long heap_allocations_at_start;
+
+  // Writes the accepted requests to a trace, with capture_trace in the config
+  TraceCapture* capture = NULL;
+
+  // Ticks the channels in parallel when memory_threads > 1
+  WorkerPool* pool = NULL;
+  // What tick() tallies for a channel, for each cycle of a parallel quantum
+  struct ChannelCycle {
+      bool active;
+      int readq;
+      int writeq;
+      int served;  // number of reads served by the end of the cycle
+  };
+  vector<vector<ChannelCycle>> quantum;
 public:
     enum class Type {
         ChRaBaRoCo,
@@ -183,10 +215,42 @@ public:
             .precision(6)
             ;
 
+        num_heap_allocations
+            .name("heap_allocations")
+            .desc("Number of heap allocations made while simulating")
+            .precision(0)
+            ;
+        heap_allocations_per_request
+            .name("heap_allocations_per_request")
+            .desc("Number of heap allocations made while simulating per incoming request")
+            .precision(6)
+            ;
+        heap_allocations_at_start = heap_allocations();
+
+        // The channels share the spec, which ALDRAM retimes with the
+        // temperature, and DSARP picks the banks to refresh with rand(), so
+        // they tick serially. So do traced commands, which would interleave.
+        // Threads beyond the cores of the host would only spin against each
+        // other at every barrier.
+        int threads = min(configs.get_memory_threads(), int(ctrls.size()));
+        if (thread::hardware_concurrency())
+            threads = min(threads, int(thread::hardware_concurrency()));
+        if (threads > 1 && !is_same<T, ALDRAM>::value && !is_same<T, DSARP>::value
+                && !configs.print_cmd_trace()) {
+            pool = new WorkerPool(threads);
+            quantum.resize(ctrls.size());
+            for (auto ctrl : ctrls)
+                ctrl->defer_callbacks = true;
+        }
+
+        if (configs.has_capture_trace())
+            capture = new TraceCapture(configs["capture_trace"].c_str());
     }
 
     ~Memory()
     {
+        delete capture;
+        delete pool;
         for (auto ctrl: ctrls)
             delete ctrl;
         delete spec;
@@ -199,6 +263,11 @@ public:
 
     void tick()
     {
+        if (pool) {
+            tick(1);
+            return;
+        }
+
         ++num_dram_cycles; //ll: what has been done in a mem cycle?
 
         bool is_active = false;
@@ -223,6 +292,100 @@ public:
         in_queue_read_req_num_sum += cur_que_readreq_num;
         in_queue_write_req_num_sum += cur_que_writereq_num;
     }
+
+    // Equivalent to calling tick() for each of the given number of cycles, in
+    // which the caller neither sends requests nor looks at the memory. With a
+    // worker pool, the channels tick the whole quantum in parallel between two
+    // barriers. The served reads are then called back in the order of a
+    // serial run (by cycle, then by channel), so results are unchanged.
+    void tick(int cycles)
+    {
+        if (!pool) {
+            for (int i = 0; i < cycles; i++)
+                tick();
+            return;
+        }
+
+        auto tick_channel = [this, cycles] (int c) {
+            Controller<T>* ctrl = ctrls[c];
+            vector<ChannelCycle>& record = quantum[c];
+            if (int(record.size()) < cycles)
+                record.resize(cycles);
+            for (int i = 0; i < cycles; i++) {
+                record[i].active = ctrl->is_active();
+                ctrl->tick();
+                record[i].readq = ctrl->readq.size();
+                record[i].writeq = ctrl->writeq.size();
+                record[i].served = ctrl->served.size();
+            }
+        };
+        pool->run(ctrls.size(), tick_channel);
+
+        for (int i = 0; i < cycles; i++) {
+            ++num_dram_cycles;
+
+            bool is_active = false;
+            int cur_que_req_num = 0;
+            int cur_que_readreq_num = 0;
+            int cur_que_writereq_num = 0;
+            for (unsigned int c = 0; c < ctrls.size(); c++) {
+                ChannelCycle& cycle = quantum[c][i];
+                is_active = is_active || cycle.active;
+                cur_que_req_num += cycle.readq + cycle.writeq;
+                cur_que_readreq_num += cycle.readq;
+                cur_que_writereq_num += cycle.writeq;
+
+                vector<Request>& served = ctrls[c]->served;
+                for (int j = i ? quantum[c][i - 1].served : 0; j < cycle.served; j++)
+                    served[j].callback(served[j]);
+            }
+            if (is_active) {
+              ramulator_active_cycles++;
+            }
+            in_queue_req_num_sum += cur_que_req_num;
+            in_queue_read_req_num_sum += cur_que_readreq_num;
+            in_queue_write_req_num_sum += cur_que_writereq_num;
+        }
+
+        for (auto ctrl : ctrls)
+            ctrl->served.clear();
+    }
+
+    // Number of upcoming memory cycles in which no controller has anything
+    // to do but tally statistics; they can be fast-forwarded with skip()
+    long get_idle_cycles()
+    {
+        long next_clk = numeric_limits<long>::max();
+        for (auto ctrl : ctrls)
+            next_clk = min(next_clk, ctrl->get_next_clk());
+        return next_clk - ctrls[0]->clk - 1;
+    }
+
+    // Equivalent to calling tick() for each of the given number of idle cycles
+    void skip(long cycles)
+    {
+        num_dram_cycles += cycles;
+
+        bool is_active = false;
+        for (auto ctrl : ctrls) {
+          is_active = is_active || ctrl->is_active();
+          ctrl->skip(cycles);
+        }
+        if (is_active) {
+          ramulator_active_cycles += cycles;
+        }
+        int cur_que_req_num = 0;
+        int cur_que_readreq_num = 0;
+        int cur_que_writereq_num = 0;
+        for (auto ctrl : ctrls) {
+          cur_que_req_num += ctrl->readq.size() + ctrl->writeq.size();
+          cur_que_readreq_num += ctrl->readq.size();
+          cur_que_writereq_num += ctrl->writeq.size();
+        }
+        in_queue_req_num_sum += cycles * cur_que_req_num;
+        in_queue_read_req_num_sum += cycles * cur_que_readreq_num;
+        in_queue_write_req_num_sum += cycles * cur_que_writereq_num;
+    }
     /*
 	 *@Request: a memory access request.
 	 *
@@ -274,12 +437,24 @@ public:
               ++incoming_write_reqs_per_channel[req.addr_vec[int(T::Level::Channel)]];
             }
             ++incoming_requests_per_channel[req.addr_vec[int(T::Level::Channel)]];
+            if (capture)
+                capture->record(req);
             return true;
         }
 
         return false;
     }
 
+    // The channel whose controller send() gives a request for addr to
+    int get_channel(long addr)
+    {
+        clear_lower_bits(addr, tx_bits);
+        if (type == Type::ChRaBaRoCo)
+            for (int i = addr_bits.size() - 1; i > 0; i--)
+                slice_lower_bits(addr, addr_bits[i]);
+        return slice_lower_bits(addr, addr_bits[0]);
+    }
+
     int pending_requests()
     {
         int reqs = 0;
@@ -289,6 +464,8 @@ public:
     }
 
     void finish(void) {
+      if (capture)
+        capture->close();
       dram_capacity = max_address;
       int *sz = spec->org_entry.count;
       maximum_bandwidth = spec->speed_entry.rate * 1e6 * spec->channel_width * sz[int(T::Level::Channel)] / 8;
@@ -303,6 +480,9 @@ public:
       in_queue_req_num_avg = in_queue_req_num_sum.value() / dram_cycles;
       in_queue_read_req_num_avg = in_queue_read_req_num_sum.value() / dram_cycles;
       in_queue_write_req_num_avg = in_queue_write_req_num_sum.value() / dram_cycles;
+
+      num_heap_allocations = heap_allocations() - heap_allocations_at_start;
+      heap_allocations_per_request = num_heap_allocations.value() / num_incoming_requests.value();
     }
 
 private:
@@ -347,6 +527,9 @@ protected:
   ScalarStat in_queue_write_req_num_avg;
 
   long max_address;
+
+  // Writes the accepted requests to a trace, with capture_trace in the config
+  TraceCapture* capture = NULL;
 public:
     enum class Type {
         ChRaBaRoCo,
@@ -467,10 +650,13 @@ public:
             .precision(6)
             ;
 
+        if (configs.has_capture_trace())
+            capture = new TraceCapture(configs["capture_trace"].c_str());
     }
 
     ~Memory()
     {
+        delete capture;
         for (auto ctrl: ctrls)
             delete ctrl;
         delete spec;
@@ -539,6 +725,8 @@ public:
               ++incoming_write_reqs_per_channel[req.addr_vec[int(T::Level::Channel)]];
             }
             ++incoming_requests_per_channel[req.addr_vec[int(T::Level::Channel)]];
+            if (capture)
+                capture->record(req);
             return true;
         }
 
@@ -554,6 +742,8 @@ public:
     }
 
     void finish(void) {
+      if (capture)
+        capture->close();
       dram_capacity = max_address;
       int *sz = spec->org_entry.count;
       maximum_bandwidth = spec->speed_entry.rate * 1e6 * spec->channel_width * sz[int(T::Level::Channel)] / 8;
@@ -0,0 +1,275 @@
+#include "MultiprogramMetrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace ramulator;
+
+// 64-bit FNV-1a
+static const uint64_t fnv_basis = 0xcbf29ce484222325ull;
+
+static uint64_t fnv(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+MultiprogramMetrics::MultiprogramMetrics(const Config& configs, const vector<const char*>& files,
+        function<void(const Config&, const char*)> run)
+    : run(run)
+{
+    if (configs.has_regions()) {
+        cerr << "multiprogram_metrics needs whole traces, it does not work with regions" << endl;
+        exit(1);
+    }
+    jobs = configs.contains("alone_jobs") ? atoi(configs["alone_jobs"].c_str()) : 1;
+    if (jobs <= 0) {
+        cerr << "alone_jobs must be positive: " << configs["alone_jobs"] << endl;
+        exit(1);
+    }
+    cache = configs["alone_cache"] == "off" ? "" : configs["alone_cache"];
+    if (cache == "") {
+        char dir[] = "/tmp/ramulator-alone-XXXXXX";
+        if (!mkdtemp(dir)) {
+            cerr << "Cannot make a directory for the alone runs: " << strerror(errno) << endl;
+            exit(1);
+        }
+        temp = dir;
+    } else if (mkdir(cache.c_str(), 0777) && errno != EEXIST) {
+        cerr << "Cannot make alone_cache directory: " << cache << ": " << strerror(errno) << endl;
+        exit(1);
+    }
+
+    for (size_t c = 0; c < files.size(); c++) {
+        Alone alone = {configs, files[c], ""};
+        alone.configs.set("trace_type", "CPU");
+        alone.configs.set("early_exit", "on");
+        alone.configs.set("capture_trace", "off");
+        if (configs.has_trace_generator())
+            alone.configs.set("generator_core", to_string(c));
+        char name[64];
+        snprintf(name, sizeof(name), "/%016llx-%016llx.stats", (unsigned long long)hash_file(files[c]),
+            (unsigned long long)hash_configs(alone.configs));
+        alone.stats = (cache != "" ? cache : temp) + name;
+        runs.push_back(alone);
+    }
+}
+
+// The trace file, or the name of a generated trace
+uint64_t MultiprogramMetrics::hash_file(const char* fname)
+{
+    uint64_t hash = fnv_basis;
+    FILE* file = fopen(fname, "rb");
+    if (!file)
+        return fnv(hash, fname, strlen(fname));
+    vector<char> buffer(1 << 20);
+    size_t size;
+    while ((size = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+        hash = fnv(hash, buffer.data(), size);
+    fclose(file);
+    return hash;
+}
+
+// The options that an alone run depends on
+uint64_t MultiprogramMetrics::hash_configs(const Config& configs)
+{
+    static const char* ignored[] = {
+        "cores_count", "core_threads", "core_quantum", "memory_threads", "trace_prefetch",
+        "multiprogram_metrics", "alone_jobs", "alone_cache"
+    };
+    uint64_t hash = fnv_basis;
+    for (auto& option : configs.get_options()) {
+        if (find(begin(ignored), end(ignored), option.first) != end(ignored))
+            continue;
+        string line = option.first + "=" + option.second + "\n";
+        hash = fnv(hash, line.data(), line.size());
+    }
+    return hash;
+}
+
+void MultiprogramMetrics::start()
+{
+    vector<int> pending;
+    for (size_t c = 0; c < runs.size(); c++) {
+        if (access(runs[c].stats.c_str(), R_OK) == 0)
+            printf("alone run of %s: cached in %s\n", runs[c].file, runs[c].stats.c_str());
+        else
+            pending.push_back(c);
+    }
+    if (pending.empty())
+        return;
+
+    printf("simulating %zu alone runs, %d at a time\n", pending.size(), jobs);
+    fflush(stdout);
+    fflush(stderr);
+    launcher = fork();
+    if (launcher < 0) {
+        cerr << "Cannot fork the alone runs: " << strerror(errno) << endl;
+        exit(1);
+    }
+    if (launcher == 0)
+        launch(pending);
+}
+
+/*
+ * in a process of its own, which has no threads yet to fork with: run the
+ * pending alone runs, jobs of them at once, and exit. Each writes its stats
+ * to a file of its own that is renamed once the run is through, so that the
+ * cache never holds the stats of a run cut short.
+ */
+void MultiprogramMetrics::launch(const vector<int>& pending)
+{
+    int null = open("/dev/null", O_WRONLY);
+    if (null >= 0)
+        dup2(null, STDOUT_FILENO);
+
+    map<pid_t, int> running;
+    size_t next = 0;
+    bool failed = false;
+    while (next < pending.size() || running.size()) {
+        if (next < pending.size() && int(running.size()) < jobs && !failed) {
+            int c = pending[next++];
+            string part = runs[c].stats + "." + to_string(getpid()) + ".part";
+            pid_t pid = fork();
+            if (pid == 0) {
+                Stats::statlist.output(part);
+                run(runs[c].configs, runs[c].file);
+                exit(0);
+            }
+            if (pid < 0) {
+                cerr << "Cannot fork the alone run of " << runs[c].file << ": " << strerror(errno) << endl;
+                failed = true;
+            } else {
+                running[pid] = c;
+            }
+            continue;
+        }
+        if (running.empty())
+            break;
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0)
+            break;
+        int c = running[pid];
+        running.erase(pid);
+        string part = runs[c].stats + "." + to_string(getpid()) + ".part";
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && rename(part.c_str(), runs[c].stats.c_str()) == 0)
+            continue;
+        cerr << "The alone run of " << runs[c].file << " failed" << endl;
+        unlink(part.c_str());
+        failed = true;
+    }
+    _exit(failed ? 1 : 0);
+}
+
+bool MultiprogramMetrics::read_stats(const string& fname, double& insts, double& cycles)
+{
+    ifstream file(fname);
+    string line;
+    bool has_insts = false, has_cycles = false;
+    while (getline(file, line)) {
+        istringstream fields(line);
+        string name;
+        double value;
+        if (!(fields >> name >> value))
+            continue;
+        if (name == "ramulator.cpu_instructions") {
+            insts = value;
+            has_insts = true;
+        } else if (name == "ramulator.cpu_cycles") {
+            cycles = value;
+            has_cycles = true;
+        }
+    }
+    return has_insts && has_cycles;
+}
+
+void MultiprogramMetrics::finish(const vector<long>& insts, const vector<long>& cycles)
+{
+    if (launcher > 0) {
+        int status;
+        if (waitpid(launcher, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            cerr << "The alone runs failed" << endl;
+            exit(1);
+        }
+    }
+
+    double weighted = 0;
+    double slowdowns = 0;
+    double max_slowdown = 0;
+    for (size_t c = 0; c < runs.size(); c++) {
+        double alone_insts, alone_cycles;
+        if (!read_stats(runs[c].stats, alone_insts, alone_cycles)) {
+            cerr << "Bad stats of the alone run of " << runs[c].file << ": " << runs[c].stats << endl;
+            exit(1);
+        }
+        double alone = alone_cycles ? alone_insts / alone_cycles : 0;
+        double shared = cycles[c] ? double(insts[c]) / cycles[c] : 0;
+        double slow = shared ? alone / shared : 0;
+        weighted += alone ? shared / alone : 0;
+        slowdowns += slow;
+        max_slowdown = max(max_slowdown, slow);
+
+        string core = " on core[" + to_string(c) + "]";
+        alone_ipc.emplace_back();
+        alone_ipc.back()
+            .name("alone_ipc" + core)
+            .desc(string("IPC of ") + runs[c].file + " run alone")
+            .precision(6)
+            ;
+        alone_ipc.back() = alone;
+        shared_ipc.emplace_back();
+        shared_ipc.back()
+            .name("shared_ipc" + core)
+            .desc("IPC of the core in the mix, up to the cycle it finished its trace in")
+            .precision(6)
+            ;
+        shared_ipc.back() = shared;
+        slowdown.emplace_back();
+        slowdown.back()
+            .name("slowdown" + core)
+            .desc("Alone IPC over the IPC in the mix")
+            .precision(6)
+            ;
+        slowdown.back() = slow;
+    }
+
+    speedups.resize(3);
+    speedups[0]
+        .name("weighted_speedup")
+        .desc("Sum over the cores of the IPC in the mix over the alone IPC")
+        .precision(6)
+        ;
+    speedups[0] = weighted;
+    speedups[1]
+        .name("harmonic_speedup")
+        .desc("Number of cores over the sum of their slowdowns")
+        .precision(6)
+        ;
+    speedups[1] = slowdowns ? runs.size() / slowdowns : 0;
+    speedups[2]
+        .name("maximum_slowdown")
+        .desc("Largest slowdown of a core, the unfairness of the mix")
+        .precision(6)
+        ;
+    speedups[2] = max_slowdown;
+
+    if (temp != "") {
+        for (auto& alone : runs)
+            unlink(alone.stats.c_str());
+        rmdir(temp.c_str());
+    }
+}
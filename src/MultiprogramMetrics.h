@@ -0,0 +1,78 @@
+#ifndef __MULTIPROGRAMMETRICS_H
+#define __MULTIPROGRAMMETRICS_H
+
+#include "Config.h"
+#include "Statistics.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace ramulator
+{
+
+/* Metrics of a multiprogram mix, with multiprogram_metrics in the config:
+ * how much each core of a multicore run slows down against its trace run
+ * alone on the same system, in cpu mode.
+ *
+ * The alone runs are simulated by processes of their own, forked before the
+ * multicore run starts and running beside it, alone_jobs of them at once.
+ * With alone_cache set to a directory, the stats of each alone run are kept
+ * there, named after a hash of the trace file and one of the config, and
+ * later runs of the same trace and config read them instead of simulating
+ * it again; clear the directory when the simulator changes.
+ *
+ * IPC counts the instructions of the whole trace, writebacks too, like the
+ * cpu_instructions stat of the alone run does, over the cycles up to the one
+ * a core finished its trace in. The slowdown of a core is its alone IPC over
+ * its IPC in the mix; the weighted speedup sums the inverses of the
+ * slowdowns, the harmonic speedup is the number of cores over their sum, and
+ * the maximum slowdown (unfairness) is the largest.
+ */
+class MultiprogramMetrics
+{
+public:
+    // run simulates a trace alone in cpu mode, with the stats going to
+    // the file set in Stats::statlist
+    MultiprogramMetrics(const Config& configs, const std::vector<const char*>& files,
+        std::function<void(const Config&, const char*)> run);
+
+    // Start the alone runs that are not cached; call before the multicore
+    // run starts any thread
+    void start();
+
+    // Wait for the alone runs and add the metrics to the stats, from the
+    // instructions (Processor::fetched) and cycles of each core in the
+    // multicore run
+    void finish(const std::vector<long>& insts, const std::vector<long>& cycles);
+
+private:
+    struct Alone {
+        Config configs;
+        const char* file;
+        std::string stats;  // file its stats go to
+    };
+    std::vector<Alone> runs;
+    std::function<void(const Config&, const char*)> run;
+    int jobs;
+    std::string cache;
+    std::string temp;  // directory of the stats without a cache, removed at the end
+    pid_t launcher = -1;
+
+    // made in finish(), so that the alone runs do not print them
+    std::deque<ScalarStat> alone_ipc;
+    std::deque<ScalarStat> shared_ipc;
+    std::deque<ScalarStat> slowdown;
+    std::deque<ScalarStat> speedups;  // weighted, harmonic, then maximum slowdown
+
+    void launch(const std::vector<int>& pending);
+    static uint64_t hash_file(const char* fname);
+    static uint64_t hash_configs(const Config& configs);
+    static bool read_stats(const std::string& fname, double& insts, double& cycles);
+};
+
+} /*namespace ramulator*/
+
+#endif /*__MULTIPROGRAMMETRICS_H*/
@@ -1,7 +1,13 @@
 #include "Processor.h"
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace ramulator;
@@ -46,9 +52,13 @@ using namespace ramulator;
 
 
 Processor::Processor(const Config& configs, const char* trace_fname, function<bool(Request)> send)
-    : send(send), callback(bind(&Processor::receive, this, placeholders::_1)), trace(trace_fname)
+    : send(send), callback(Callback::bind<Processor, &Processor::receive>(this)), trace(configs, trace_fname),
+      window(configs.get_window_depth())
 {
+    if (configs.trace_prefetch())
+        trace.prefetch(TraceHeader::Kind::CPU);
     more_reqs = trace.get_request(bubble_cnt, req_addr, req_type);
+    dependent_reads = trace.has_dependent_reads();
 
     // regStats
     memory_access_cycles.name("memory_access_cycles")
@@ -70,9 +80,13 @@ Processor::Processor(const Config& configs, const char* trace_fname, function<bo
 	
 }
 Processor::Processor(const Config& configs, const char* trace_fname, function<bool(Request)> send, int id)
-  : id(id),send(send), callback(bind(&Processor::receive, this, placeholders::_1)), trace(trace_fname)
+  : id(id),send(send), callback(Callback::bind<Processor, &Processor::receive>(this)), trace(configs, trace_fname, id),
+    window(configs.get_window_depth())
 {
+    if (configs.trace_prefetch())
+        trace.prefetch(TraceHeader::Kind::CPU);
     more_reqs = trace.get_request(bubble_cnt, req_addr, req_type);
+    dependent_reads = trace.has_dependent_reads();
 
     // regStats
     memory_access_cycles.name("memory_access_cycles")
@@ -133,7 +147,11 @@ void Processor::tick()
 	
     retired += window.retire();
 
-    if (!more_reqs) return;
+    if (!more_reqs) {
+        if (!finished_clk && window.is_empty())
+            finished_clk = clk;
+        return;
+    }
     // bubbles (non-memory operations)
     int inserted = 0;
     while (bubble_cnt > 0) {
@@ -146,23 +164,32 @@ void Processor::tick()
         inserted++;
         bubble_cnt--;
         cpu_inst++;
+        fetched++;
     }
 
     if (req_type == Request::Type::READ) { // read request is inserted into ooo window, while write request is not.
         // read request
         if (inserted == window.ipc) return;
         if (window.is_full()) return;
+        if (blocking_read != -1) return; // the address depends on a read in flight
 
         //Request req(req_addr, req_type, callback);
         Request req(req_addr, req_type, callback,id);
 		if(clk%100==0) printf("lele: in %s: send read request <addr: 0x%lx, type %d> on core %d, cycle %ld\n"
 				,__FUNCTION__,req_addr,req_type,id,clk);
-        if (!send(req)) return;//ll: call 'send(req)'. count for request in channel ctrl.
+        // set before send(), which may serve the read right away
+        if (dependent_reads) blocking_read = req_addr;
+        if (!send(req)) {//ll: call 'send(req)'. count for request in channel ctrl.
+            blocking_read = -1;
+            return;
+        }
 
         //cout << "Inserted: " << clk << "\n";
 
         window.insert(false, req_addr);
         cpu_inst++;
+        fetched++;
+        requests++;
         more_reqs = trace.get_request(bubble_cnt, req_addr, req_type); //ll: get next request
         return;
     }
@@ -175,11 +202,62 @@ void Processor::tick()
 				,__FUNCTION__,req_addr,req_type,id,clk);
         if (!send(req)) return; //ll: call send(req), count for request in channel ctrl.
         cpu_inst++;
+        fetched++;
+        requests++;
     }
 
     more_reqs = trace.get_request(bubble_cnt, req_addr, req_type);
 }
 
+/* Whether tick() can make no progress until memory serves one of our reads:
+ *  the oldest instruction is not ready to retire, and there is either
+ *  nothing left in the trace, no room in the window for what comes next, or
+ *  the next read waits for one that is in flight.
+ */
+bool Processor::is_stalled()
+{
+    if (window.can_retire()) return false;
+    if (!more_reqs) return true;
+    if (blocking_read != -1 && bubble_cnt == 0 && req_type == Request::Type::READ) return true;
+    return window.is_full() && (bubble_cnt > 0 || req_type == Request::Type::READ);
+}
+
+// Equivalent to calling tick() for each of the given number of stalled cycles
+void Processor::skip(long cycles)
+{
+    clk += cycles;
+    cpu_cycles += cycles;
+    core_cycles += cycles;
+}
+
+// Take the given number of instructions from the trace without simulating them
+void Processor::fast_forward(long insts)
+{
+    // jump to the last checkpoint before the target if the trace has an
+    // index, and we are not past that checkpoint already
+    long target = fetched + insts;
+    long indexed = trace.indexed_before(TraceHeader::Kind::CPU, target);
+    if (indexed > fetched) {
+        trace.seek(indexed);
+        fetched = indexed;
+        insts = target - indexed;
+        more_reqs = trace.get_request(bubble_cnt, req_addr, req_type);
+    }
+
+    while (insts > 0 && more_reqs) {
+        if (bubble_cnt > 0) {
+            long n = min(bubble_cnt, insts);
+            bubble_cnt -= n;
+            insts -= n;
+            fetched += n;
+            continue;
+        }
+        insts--;
+        fetched++;
+        more_reqs = trace.get_request(bubble_cnt, req_addr, req_type);
+    }
+}
+
 bool Processor::finished()
 {
     return !more_reqs && window.is_empty();
@@ -187,6 +265,12 @@ bool Processor::finished()
 void Processor::receive(Request& req) 
 {
     window.set_ready(req.addr);// when CPU get data from memory. Set ready for the address in the Window
+    if (req.addr == blocking_read)
+        blocking_read = -1;
+    if (req.depart - req.arrive > 1) { // not forwarded from a write, like in Controller
+        reads_served++;
+        read_latency += req.depart - req.arrive;
+    }
     if (req.arrive != -1 && req.depart > last) { //what's this? After get one data in the Window?
       memory_access_cycles += (req.depart - max(last, req.arrive));
       last = req.depart;
@@ -198,23 +282,41 @@ int Processor::getID(){
 }
 
 
-bool Window::is_full()
+Window::Window(int depth) : depth(depth), slots(depth)
 {
-    return load == depth;
+    assert(depth > 0);
+    size_t size = 1;
+    while (size < 2 * size_t(depth))
+        size <<= 1;
+    waiting.assign(size, {0, -1});
+    mask = size - 1;
 }
 
-bool Window::is_empty()
+/*
+ * the entry of addr in waiting, or the free entry where it would go.
+ */
+size_t Window::find(long addr) const
 {
-    return load == 0;
+    size_t i = home(addr);
+    while (waiting[i].first != -1 && waiting[i].addr != addr)
+        i = (i + 1) & mask;
+    return i;
 }
 
-
 void Window::insert(bool ready, long addr)
 {
-    assert(load <= depth);
-
-    ready_list.at(head) = ready;
-    addr_list.at(head) = addr;
+    assert(load < depth);
+
+    Slot& slot = slots[head];
+    slot.addr = addr;
+    slot.ready = ready;
+    slot.next = -1;
+    if (!ready) {
+        Waiting& entry = waiting[find(addr)];
+        entry.addr = addr;
+        slot.next = entry.first;
+        entry.first = head;
+    }
 
     head = (head + 1) % depth;
     load++;
@@ -223,8 +325,8 @@ void Window::insert(bool ready, long addr)
 /*Rq: retire: 
  * 		delete the ready Insts in the ooo window; return the number of Insts deleted.
  *
- *** 	*the window is presented by 'vector<bool> ready_list' and 'vector<long> addr_list',
- 		 using 'tail' and 'head' to index the last and first elements; The head is the newest inserted.
+ *** 	*the slots of the window form a ring, using 'tail' and 'head' to index the
+ 		 oldest slot and the next free one; The head is where the newest is inserted.
  **/
 long Window::retire()
 {
@@ -234,7 +336,7 @@ long Window::retire()
 
     int retired = 0;
     while (load > 0 && retired < ipc) {
-        if (!ready_list.at(tail)) 
+        if (!slots[tail].ready) 
             break;
 
         tail = (tail + 1) % depth;
@@ -250,25 +352,118 @@ void Window::set_ready(long addr)
 {
     if (load == 0) return;
 
-    for (int i = 0; i < load; i++) {
-        int index = (tail + i) % depth;
-        if (addr_list.at(index) != addr)
-            continue;
-        ready_list.at(index) = true;
+    size_t i = find(addr);
+    if (waiting[i].first == -1)
+        return;
+    for (int slot = waiting[i].first; slot != -1; slot = slots[slot].next)
+        slots[slot].ready = true;
+
+    // free the entry, and move back the entries after it that would no
+    // longer be found past the hole
+    waiting[i].first = -1;
+    for (size_t j = (i + 1) & mask; waiting[j].first != -1; j = (j + 1) & mask) {
+        if (((j - home(waiting[j].addr)) & mask) >= ((j - i) & mask)) {
+            waiting[i] = waiting[j];
+            waiting[j].first = -1;
+            i = j;
+        }
     }
 }
 
 
 
-Trace::Trace(const char* trace_fname) : file(trace_fname)
+Trace::Trace(const char* trace_fname)
 { 
+    open(trace_fname);
+}
+
+Trace::Trace(const Config& configs, const char* trace_fname, int id)
+{
+    text_timed_ns = configs["trace_timestamps"] == "ns";
+    if (!configs.has_trace_generator()) {
+        fname = trace_fname;
+        importer = TraceImporter::create(configs, trace_fname);
+        if (importer)
+            return;
+        open(trace_fname);
+        text_timed = !map && configs.has_trace_timestamps();
+        return;
+    }
+    fname = trace_fname;
+    generator = new TraceGenerator(configs, id);
+}
+
+void Trace::open(const char* trace_fname)
+{
 	fname=trace_fname;
-    if (!file.good()) {
+    if (open_binary(trace_fname)) {
+        index = TraceIndex::load(trace_fname, TraceEncoding::Binary);
+        return;
+    }
+    if (!text.open(trace_fname)) {
         std::cerr << "Bad trace file: " << trace_fname << std::endl;
         exit(1);
     }else{
+        parsed.reserve(parse_batch);
     	std::cout << "lelema: in Processor.cpp, Trace::Trace(): good trace file: " << trace_fname << std::endl;
     }
+    index = TraceIndex::load(trace_fname, text.encoding());
+}
+
+Trace::~Trace()
+{
+    if (ring) {
+        ring->stop();
+        reader.join();
+        delete ring;
+    }
+    if (map)
+        munmap((void*)map, map_size);
+    delete generator;
+    delete importer;
+    delete index;
+}
+
+/*
+ * map the trace file if it starts with the header of a binary trace.
+ */
+bool Trace::open_binary(const char* trace_fname)
+{
+    int fd = ::open(trace_fname, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    TraceHeader header;
+    struct stat st;
+    if (read(fd, &header, sizeof(header)) != sizeof(header) || !header.is_valid() || fstat(fd, &st)) {
+        close(fd);
+        return false;
+    }
+    if (header.version != TraceHeader::current_version) {
+        std::cerr << "Unsupported version " << header.version << " of binary trace file: " << trace_fname << std::endl;
+        exit(1);
+    }
+
+    map_size = st.st_size;
+    void* addr = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Bad trace file: " << trace_fname << std::endl;
+        exit(1);
+    }
+    madvise(addr, map_size, MADV_SEQUENTIAL);
+
+    map = (const unsigned char*)addr;
+    records = pos = map + sizeof(header);
+    kind = header.kind;
+    return true;
+}
+
+static const char* skip_spaces(const char* pos)
+{
+    while (*pos == ' ')
+        pos++;
+    return pos;
 }
 
 /*
@@ -279,85 +474,471 @@ Trace::Trace(const char* trace_fname) : file(trace_fname)
 
 bool Trace::get_request(long& bubble_cnt, long& req_addr, Request::Type& req_type)
 {
-    static bool has_write = false;
-    static long write_addr;
-    static int line_num = 0;
-	
-	 //ll:'has_write' is a common var for all instances of Trace::get_request(), 
-	 //ll: see static var: http://stackoverflow.com/questions/6223355/static-variables-in-class-methods
-    if (has_write){
+    if (pending_write){
         bubble_cnt = 0;
-        req_addr = write_addr;
+        req_addr = pending_write_addr;
         req_type = Request::Type::WRITE;
-        has_write = false;
+        pending_write = false;
         return true;
     }
-	//ll: read one line from trace file
-    string line;
-	getline(file, line);
-    line_num ++;
-	if (file.eof() || line.size() == 0) { //ll:reach the end of the line; or reach blank line; stop.
-        file.clear();
-        file.seekg(0);
-        // getline(file, line);
-        line_num = 0;
+
+    if (!get_cpu_record(bubble_cnt, req_addr, pending_write, pending_write_addr))
         return false;
+    req_type = Request::Type::READ; // all read ????
+    return true; //read a request successfully from the trace file.
+}
+
+bool Trace::get_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr)
+{
+    if (!ring)
+        return read_cpu_record(bubble_cnt, read_addr, has_write, write_addr);
+
+    const Record& rec = pop();
+    if (rec.last)
+        return false;
+    bubble_cnt = rec.bubble_cnt;
+    read_addr = rec.addr;
+    has_write = rec.has_write;
+    write_addr = rec.write_addr;
+    return true;
+}
+
+bool Trace::read_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr)
+{
+    if (generator)
+        return generator->get_cpu_record(bubble_cnt, read_addr, has_write, write_addr);
+    if (importer)
+        return importer->get_cpu_record(bubble_cnt, read_addr, has_write, write_addr);
+
+    if (map) {
+        assert(kind == TraceHeader::Kind::CPU && "Not a cpu trace");
+        const unsigned char* end = map + map_size;
+        uint64_t head, read_delta, write_delta = 0;
+        if (pos == end) { // rewind like a text trace
+            pos = records;
+            last_addr = 0;
+            return false;
+        }
+        bool good = read_varint(pos, end, head) && read_varint(pos, end, read_delta)
+            && (!(head & 1) || read_varint(pos, end, write_delta));
+        if (!good) {
+            std::cerr << "Truncated trace file: " << fname << std::endl;
+            exit(1);
+        }
+        bubble_cnt = head >> 1;
+        read_addr = last_addr + unzigzag(read_delta);
+        has_write = head & 1;
+        write_addr = read_addr + unzigzag(write_delta);
+        last_addr = read_addr;
+        return true;
     }
 
-	
-	//skip the line start with #. lele, 12-20-2015
-	while (line.at(line.find_first_not_of(' '))=='#'){
-		printf("lele: skip line %d in %s: '%s'\n",line_num,fname,line.c_str());
-		getline(file, line);
-    	line_num ++;
-		if (file.eof() || line.size() == 0) { //ll:reach the end of the line; or reach blank line; stop.
-	        file.clear();
-	        file.seekg(0);
-	        // getline(file, line);
-	        line_num = 0;
-	        return false;
-    	}
-	}
-    //printf("lele: get line %d in %s: '%s'\n",line_num,fname,line.c_str());
-	//exit(0);
-	//ll: parse one request line. Format: <bubble, addr, type>
-    size_t pos, end;
-    bubble_cnt = std::stoul(line, &pos, 10);
-    //std::cout << "lelema: in Processor.cpp, Trace::get_request(): Bubble_Count: " << bubble_cnt << std::endl;
-
-    pos = line.find_first_not_of(' ', pos+1);
-    req_addr = stoul(line.substr(pos), &end, 0);
-    //std::cout << "lelema: in Processor.cpp, Trace::get_request(): Req_Addr: " << req_addr << std::endl;
-    req_type = Request::Type::READ; // all read ????
+    if (parsed_next == parsed.size())
+        parse_cpu_lines();
+    const Record& rec = parsed[parsed_next++];
+    if (rec.last)
+        return false;
+    bubble_cnt = rec.bubble_cnt;
+    read_addr = rec.addr;
+    has_write = rec.has_write;
+    write_addr = rec.write_addr;
+    return true;
+}
 
-    pos = line.find_first_not_of(' ', pos+end);
-    if (pos != string::npos){
-        has_write = true;
-        write_addr = stoul(line.substr(pos), NULL, 0);
-	//	std::cout << "lelema: in "<<__FUNCTION__<<": trace line "<<line_num<<"<" << bubble_cnt<<","<<req_addr <<","<<write_addr<<">"<< std::endl;
+/*
+ * parse the next batch of lines of a cpu trace. The batch ends early at the
+ * end of the trace (the end of the file or a blank line), where the trace
+ * starts over.
+ */
+void Trace::parse_cpu_lines()
+{
+    parsed.clear();
+    parsed_next = 0;
+    Record rec = Record();
+    while (parsed.size() < parse_batch) {
+        //ll: read one line from trace file
+        char* line;
+        line_num ++;
+        if (!text.get_line(line) || !*line) { //ll:reach the end of the line; or reach blank line; stop.
+            text.rewind();
+            line_num = 0;
+            rec.last = true;
+            parsed.push_back(rec);
+            return;
+        }
+
+        //skip the line start with #. lele, 12-20-2015
+        if (!parse_cpu_line(line, rec)){
+            printf("lele: skip line %d in %s: '%s'\n",line_num,fname,line);
+            continue;
+        }
+        parsed.push_back(rec);
     }
-	else{	
-	//std::cout << "lelema: in "<<__FUNCTION__<<": trace line "<<line_num<<"<" << bubble_cnt<<","<<req_addr <<">"<< std::endl;
-	}
-    return true; //read a request successfully from the trace file.
+}
+
+// parse one line of a cpu trace into rec, or return false for a comment line
+bool Trace::parse_cpu_line(const char* line, Record& rec)
+{
+    if (line[strspn(line, " ")]=='#')
+        return false;
+
+    //ll: parse one request line. Format: <bubble, addr, type>
+    unsigned long val;
+    const char* pos = parse_ulong(line, val, 10);
+    rec.bubble_cnt = val;
+
+    pos = skip_spaces(*pos ? pos + 1 : pos);
+    pos = parse_ulong(pos, val, 0);
+    rec.addr = val;
+
+    pos = skip_spaces(pos);
+    rec.has_write = *pos;
+    if (rec.has_write) {
+        parse_ulong(pos, val, 0);
+        rec.write_addr = val;
+    }
+    return true;
 }
 
 bool Trace::get_request(long& req_addr, Request::Type& req_type)
 {
-    string line;
-    getline(file, line);
-    if (file.eof()) {
+    if (!ring)
+        return read_dram_request(req_addr, req_type);
+
+    // a dram trace does not start over, nothing follows its last record
+    if (drained)
+        return false;
+    const Record& rec = pop();
+    if (rec.last) {
+        drained = true;
         return false;
     }
-    size_t pos;
-    req_addr = std::stoul(line, &pos, 16);
+    req_addr = rec.addr;
+    req_type = rec.has_write ? Request::Type::WRITE : Request::Type::READ;
+    return true;
+}
 
-    pos = line.find_first_not_of(' ', pos+1);
+bool Trace::read_dram_request(long& req_addr, Request::Type& req_type)
+{
+    if (generator) {
+        bool is_write;
+        if (!generator->get_request(req_addr, is_write))
+            return false;
+        req_type = is_write ? Request::Type::WRITE : Request::Type::READ;
+        return true;
+    }
+    assert(!importer && "Not a dram trace");
+
+    if (map) {
+        assert(kind == TraceHeader::Kind::DRAM && "Not a dram trace");
+        uint64_t record;
+        if (pos == map + map_size)
+            return false;
+        if (!read_varint(pos, map + map_size, record)) {
+            std::cerr << "Truncated trace file: " << fname << std::endl;
+            exit(1);
+        }
+        req_addr = last_addr + unzigzag(record >> 1);
+        req_type = (record & 1) ? Request::Type::WRITE : Request::Type::READ;
+        last_addr = req_addr;
+        return true;
+    }
 
-    if (pos == string::npos || line.substr(pos)[0] == 'R')
-        req_type = Request::Type::READ;
-    else if (line.substr(pos)[0] == 'W')
-        req_type = Request::Type::WRITE;
+    if (parsed_next == parsed.size())
+        parse_dram_lines();
+    const Record& rec = parsed[parsed_next++];
+    if (rec.last)
+        return false;
+    req_addr = rec.addr;
+    req_type = rec.has_write ? Request::Type::WRITE : Request::Type::READ;
+    return true;
+}
+
+bool Trace::get_timed_request(long& clk, long& req_addr, Request::Type& req_type, int& coreid)
+{
+    if (!ring)
+        return read_timed_request(clk, req_addr, req_type, coreid);
+
+    if (drained)
+        return false;
+    const Record& rec = pop();
+    if (rec.last) {
+        drained = true;
+        return false;
+    }
+    clk = rec.bubble_cnt;
+    req_addr = rec.addr;
+    req_type = rec.has_write ? Request::Type::WRITE : Request::Type::READ;
+    coreid = rec.write_addr;
+    return true;
+}
+
+bool Trace::read_timed_request(long& clk, long& req_addr, Request::Type& req_type, int& coreid)
+{
+    assert(is_timed() && "Not a timed trace");
+    if (importer) {
+        bool is_write;
+        if (!importer->get_timed_request(clk, req_addr, is_write))
+            return false;
+        req_type = is_write ? Request::Type::WRITE : Request::Type::READ;
+        coreid = 0;
+        return true;
+    }
+    if (text_timed) {
+        if (parsed_next == parsed.size())
+            parse_dram_lines();
+        const Record& rec = parsed[parsed_next++];
+        if (rec.last)
+            return false;
+        clk = rec.bubble_cnt;
+        req_addr = rec.addr;
+        req_type = rec.has_write ? Request::Type::WRITE : Request::Type::READ;
+        coreid = rec.write_addr;
+        return true;
+    }
+
+    const unsigned char* end = map + map_size;
+    uint64_t clk_delta, record, core;
+    if (pos == end)
+        return false;
+    if (!read_varint(pos, end, clk_delta) || !read_varint(pos, end, record) || !read_varint(pos, end, core)) {
+        std::cerr << "Truncated trace file: " << fname << std::endl;
+        exit(1);
+    }
+    clk = last_clk + unzigzag(clk_delta);
+    req_addr = last_addr + unzigzag(record >> 1);
+    req_type = (record & 1) ? Request::Type::WRITE : Request::Type::READ;
+    coreid = unzigzag(core);
+    last_clk = clk;
+    last_addr = req_addr;
+    return true;
+}
+
+/*
+ * parse the next batch of lines of a dram trace, up to its end.
+ */
+void Trace::parse_dram_lines()
+{
+    parsed.clear();
+    parsed_next = 0;
+    Record rec = Record();
+    while (parsed.size() < parse_batch) {
+        char* line;
+        if (!text.get_line(line)) {
+            rec.last = true;
+            parsed.push_back(rec);
+            return;
+        }
+        parse_dram_line(line, rec, text_timed);
+        parsed.push_back(rec);
+    }
+}
+
+void Trace::parse_dram_line(const char* line, Record& rec, bool timed)
+{
+    unsigned long val;
+    const char* pos = line;
+    if (timed) {
+        pos = parse_ulong(pos, val, 10);
+        rec.bubble_cnt = val;
+        pos = skip_spaces(*pos ? pos + 1 : pos);
+    }
+    pos = parse_ulong(pos, val, 16);
+    rec.addr = val;
+
+    pos = skip_spaces(*pos ? pos + 1 : pos);
+
+    if (!*pos || *pos == 'R')
+        rec.has_write = false;
+    else if (*pos == 'W')
+        rec.has_write = true;
     else assert(false);
+
+    if (timed) {
+        parse_ulong(*pos ? pos + 1 : pos, val, 10);
+        rec.write_addr = *pos ? val : 0;
+    }
+}
+
+void Trace::prefetch(TraceHeader::Kind kind)
+{
+    assert(!ring);
+    assert((!map || this->kind == kind) && "Wrong kind of trace");
+    assert((!importer || importer->kind() == kind) && "Wrong kind of trace");
+    ring = new BlockRing<Record>(prefetch_blocks, prefetch_block_size);
+    prefetch_kind = kind;
+    reader = std::thread(&Trace::prefetch_loop, this, kind);
+}
+
+const Trace::Record& Trace::pop()
+{
+    if (!block || next == block->size()) {
+        if (block)
+            ring->release();
+        block = &ring->front();
+        next = 0;
+    }
+    return (*block)[next++];
+}
+
+/*
+ * decode records a block at a time until the ring is stopped. A cpu trace
+ * starts over at its end like it does without prefetching, so only a dram
+ * trace runs out of records. Most runs end around the end of a cpu trace,
+ * so the reader parks there until the core reads on past it instead of
+ * decoding the next pass ahead.
+ */
+void Trace::prefetch_loop(TraceHeader::Kind kind)
+{
+    bool dram = kind != TraceHeader::Kind::CPU;
+    while (BlockRing<Record>::Block* records = ring->acquire()) {
+        records->clear();
+        Record rec;
+        do {
+            if (kind == TraceHeader::Kind::Timed) {
+                Request::Type type = Request::Type::READ;
+                int coreid = 0;
+                rec.last = !read_timed_request(rec.bubble_cnt, rec.addr, type, coreid);
+                rec.has_write = type == Request::Type::WRITE;
+                rec.write_addr = coreid;
+            } else if (dram) {
+                Request::Type type = Request::Type::READ;
+                rec.last = !read_dram_request(rec.addr, type);
+                rec.has_write = type == Request::Type::WRITE;
+            } else
+                rec.last = !read_cpu_record(rec.bubble_cnt, rec.addr, rec.has_write, rec.write_addr);
+            records->push_back(rec);
+        } while (!rec.last && int(records->size()) < prefetch_block_size);
+        ring->publish();
+        if (dram && rec.last)
+            return;
+        if (rec.last && !ring->drain())
+            return;
+    }
+}
+
+long Trace::indexed_before(TraceHeader::Kind kind, long insts) const
+{
+    if (!index || index->kind != uint32_t(kind))
+        return -1;
+    return index->checkpoint(insts).insts;
+}
+
+void Trace::seek(long insts)
+{
+    const TraceIndex::Checkpoint& cp = index->checkpoint(insts);
+    assert(cp.insts == insts);
+
+    // the reader thread has decoded ahead, start it over from there
+    bool prefetching = ring;
+    if (ring) {
+        ring->stop();
+        reader.join();
+        delete ring;
+        ring = NULL;
+        block = NULL;
+        next = 0;
+        drained = false;
+    }
+
+    pending_write = false;
+    parsed.clear();
+    parsed_next = 0;
+    if (map) {
+        pos = map + cp.offset;
+        last_addr = cp.last_addr;
+    } else {
+        text.seek(cp.offset, *index);
+        line_num = cp.line;
+    }
+
+    if (prefetching)
+        prefetch(prefetch_kind);
+}
+
+bool Trace::build_index(const char* fname, bool dram, long interval)
+{
+    assert(interval > 0);
+    Trace in(fname);
+    TraceHeader::Kind kind = dram ? TraceHeader::Kind::DRAM : TraceHeader::Kind::CPU;
+    if (in.map && in.kind != kind) {
+        std::cerr << "Not a " << (dram ? "dram" : "cpu") << " trace file: " << fname << std::endl;
+        return false;
+    }
+    TraceIndex index(uint32_t(kind), in.map ? TraceEncoding::Binary : in.text.encoding(), interval);
+    if (!in.map)
+        in.text.add_points(&index);
+
+    // a checkpoint may point at comment lines before its record, which
+    // are skipped again after a seek
+    long insts = 0, records = 0;
+    while (true) {
+        TraceIndex::Checkpoint cp = {insts, 0, in.line_num, in.last_addr};
+        Record rec = Record();
+        if (in.map) {
+            cp.offset = in.pos - in.map;
+            Request::Type type;
+            bool more = dram ? in.read_dram_request(rec.addr, type)
+                : in.read_cpu_record(rec.bubble_cnt, rec.addr, rec.has_write, rec.write_addr);
+            if (!more)
+                break;
+        } else {
+            cp.offset = in.text.tell();
+            char* line;
+            in.line_num++;
+            if (!in.text.get_line(line) || (!dram && !*line))
+                break;
+            // only the records of a cpu trace are needed, to count insts
+            if (!dram && !parse_cpu_line(line, rec))
+                continue;
+        }
+        if (records++ % interval == 0)
+            index.checkpoints.push_back(cp);
+        insts += dram ? 1 : rec.bubble_cnt + 1 + rec.has_write;
+    }
+
+    if (!records) {
+        std::cerr << "No records in trace file: " << fname << std::endl;
+        return false;
+    }
+    if (!index.save(fname)) {
+        std::cerr << "Cannot write trace index: " << TraceIndex::path(fname) << std::endl;
+        return false;
+    }
+    printf("indexed %ld records (%ld %s) of %s with %zu checkpoints and %zu access points in %s\n",
+        records, insts, dram ? "requests" : "instructions", fname, index.checkpoints.size(),
+        index.points.size(), TraceIndex::path(fname).c_str());
+    return true;
+}
+
+bool Trace::convert(const char* in_fname, const char* out_fname, bool dram)
+{
+    Trace in(in_fname);
+    if (in.map) {
+        std::cerr << "Already a binary trace file: " << in_fname << std::endl;
+        return false;
+    }
+    TraceWriter out(out_fname, dram ? TraceHeader::Kind::DRAM : TraceHeader::Kind::CPU);
+    long records = 0;
+    if (dram) {
+        long addr;
+        Request::Type type;
+        while (in.get_request(addr, type)) {
+            out.write_dram(addr, type == Request::Type::WRITE);
+            records++;
+        }
+    } else {
+        long bubble_cnt, read_addr, write_addr;
+        bool has_write;
+        while (in.get_cpu_record(bubble_cnt, read_addr, has_write, write_addr)) {
+            out.write_cpu(bubble_cnt, read_addr, has_write, write_addr);
+            records++;
+        }
+    }
+    if (!out.close()) {
+        std::cerr << "Cannot write trace file: " << out_fname << std::endl;
+        return false;
+    }
+    printf("converted %ld records of %s to %s\n", records, in_fname, out_fname);
     return true;
 }
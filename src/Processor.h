@@ -3,15 +3,21 @@
 
 #define __ENABLE_MULTICORES
 
+#include "BlockRing.h"
 #include "Config.h"
 #include "Request.h"
 #include "Statistics.h"
+#include "TraceFormat.h"
+#include "TraceGenerator.h"
+#include "TraceImporter.h"
+#include "TraceStream.h"
 #include <iostream>
 #include <vector>
 #include <fstream>
 #include <string>
 #include <ctype.h>
 #include <functional>
+#include <thread>
 
 namespace ramulator 
 {
@@ -19,12 +25,20 @@ namespace ramulator
 //ScalarStat cpu_cycles_main;
 //VectorStat core_cycles_main;
 
+// A trace is either text, in one of the formats below, or binary (see
+// TraceFormat.h), which is told apart by its header and read through mmap.
+// Text traces may be gzip, zstd or xz compressed and are decompressed on the
+// fly. With trace_generator in the config, the trace is synthesized instead
+// (see TraceGenerator.h) and trace_fname only names it. With trace_format,
+// it is the trace of another simulator (see TraceImporter.h).
 class Trace {
 public:
 
 	const char* fname;
 
     Trace(const char* trace_fname);
+    Trace(const Config& configs, const char* trace_fname, int id = 0);
+    ~Trace();
     // trace file format 1:
     // [# of bubbles(non-mem instructions)] [read address(dec or hex)] <optional: write address(evicted cacheline)>
     bool get_request(long& bubble_cnt, long& req_addr, Request::Type& req_type);
@@ -32,8 +46,102 @@ public:
     // [address(hex)] [R/W]
     bool get_request(long& req_addr, Request::Type& req_type);
 
+    // One line of a trace in format 1: the read and the evicted line, if any
+    bool get_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr);
+
+    // A binary trace captured from memory (see TraceCapture) holds requests
+    // with the memory cycle they arrived in and their core. So does a text
+    // trace in format 3, with trace_timestamps in the config, in the unit
+    // that it names:
+    // [timestamp(dec)] [address(hex)] [R/W] <optional: core id>
+    bool is_timed() const {
+        return (map && kind == TraceHeader::Kind::Timed) || text_timed
+            || (importer && importer->kind() == TraceHeader::Kind::Timed);
+    }
+    bool timestamps_in_ns() const {return (text_timed || importer) && text_timed_ns;}
+    bool get_timed_request(long& clk, long& req_addr, Request::Type& req_type, int& coreid);
+
+    // Write the text trace in_fname, in format 1 (dram is false) or 2, to
+    // out_fname as a binary trace
+    static bool convert(const char* in_fname, const char* out_fname, bool dram);
+
+    // From now on, decode the trace (of the given kind) ahead of time on a
+    // thread of its own, so that the calls above only take decoded records
+    void prefetch(TraceHeader::Kind kind);
+
+    // Whether each read has to wait for the read before it to be served
+    bool has_dependent_reads() const {return generator && generator->dependent_reads();}
+
+    // Write the index of a text or binary trace in format 1 (dram is false)
+    // or 2, with a checkpoint every interval records (see TraceIndex.h)
+    static bool build_index(const char* fname, bool dram, long interval);
+
+    // Instructions (requests of a dram trace) before the last indexed
+    // record at or before insts, or -1 without an index of that kind
+    long indexed_before(TraceHeader::Kind kind, long insts) const;
+    // Go on reading at the indexed record with insts before it
+    void seek(long insts);
+
 private:
-    std::ifstream file;
+    TraceStream text;
+    int line_num = 0;
+    bool text_timed = false;  // format 3
+    bool text_timed_ns = false;
+
+    // binary trace
+    const unsigned char* map = NULL;
+    size_t map_size = 0;
+    const unsigned char* records = NULL;  // first record, after the header
+    const unsigned char* pos = NULL;  // next record
+    TraceHeader::Kind kind;
+    long last_addr = 0;
+    long last_clk = 0;
+
+    TraceGenerator* generator = NULL;
+    TraceImporter* importer = NULL;
+    TraceIndex* index = NULL;
+
+    void open(const char* trace_fname);
+    bool open_binary(const char* trace_fname);
+    bool read_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr);
+    bool read_dram_request(long& req_addr, Request::Type& req_type);
+    bool read_timed_request(long& clk, long& req_addr, Request::Type& req_type, int& coreid);
+
+    // decoded records; a record marked last stands for the end of the
+    // trace, where the calls above return false
+    struct Record {
+        long bubble_cnt;  // or the clk of a timed request
+        long addr;
+        long write_addr;  // or the coreid of a timed request
+        bool has_write;  // or is_write for a dram trace
+        bool last;
+    };
+
+    // writeback of the last cpu record, which get_request() returns next
+    bool pending_write = false;
+    long pending_write_addr = 0;
+
+    // text traces are parsed a batch of lines at a time
+    static const int parse_batch = 1024;
+    std::vector<Record> parsed;
+    size_t parsed_next = 0;
+    void parse_cpu_lines();
+    void parse_dram_lines();
+    static bool parse_cpu_line(const char* line, Record& rec);
+    static void parse_dram_line(const char* line, Record& rec, bool timed);
+
+    // prefetching
+    static const int prefetch_blocks = 4;
+    static const int prefetch_block_size = 4096;
+    BlockRing<Record>* ring = NULL;
+    const BlockRing<Record>::Block* block = NULL;  // taken from the ring
+    size_t next = 0;  // next record in block
+    bool drained = false;  // the reader thread has stopped at the end
+    std::thread reader;
+    TraceHeader::Kind prefetch_kind;
+
+    const Record& pop();
+    void prefetch_loop(TraceHeader::Kind kind);
 };
 
 
@@ -41,28 +149,47 @@ private:
 * Window class: 
 *	simulate the ooo buffer ? 
 *
-*the window is presented by 'vector<bool> ready_list' and 'vector<long> addr_list',
- 		 using 'tail' and 'head' to index the last and first elements; The head is the newest inserted.
+*the window is a ring of 'depth' slots, using 'tail' and 'head' to index the oldest
+ 		 slot and the next free one; The head is where the newest is inserted.
+ 		 The slots of the reads still waiting for their data are chained by address
+ 		 from a small open-addressed table, so set_ready() only visits the reads of
+ 		 the address it is given.
 */
 
 class Window {
 public:
     int ipc = 4;
-    int depth = 128;
+    int depth;
 
-    Window() : ready_list(depth), addr_list(depth, -1) {}
-    bool is_full();
-    bool is_empty();
+    Window(int depth = 128);
+    bool is_full() const {return load == depth;}
+    bool is_empty() const {return load == 0;}
     void insert(bool ready, long addr);
     long retire();
+    bool can_retire() const {return load > 0 && slots[tail].ready;}
     void set_ready(long addr);
 
 private:
+    struct Slot {
+        long addr;
+        int next;  // next slot waiting for the same address, or -1
+        bool ready;
+    };
+
+    struct Waiting {
+        long addr;
+        int first;  // first slot waiting for addr, or -1 for a free entry
+    };
+
     int load = 0;
     int head = 0;
     int tail = 0;
-    std::vector<bool> ready_list;
-    std::vector<long> addr_list;
+    std::vector<Slot> slots;
+    std::vector<Waiting> waiting;  // linear probing, at most half full
+    size_t mask;
+
+    size_t find(long addr) const;
+    size_t home(long addr) const {return (uint64_t(addr) * 0x9e3779b97f4a7c15ull) >> 32 & mask;}
 };
 
 
@@ -71,16 +198,24 @@ public:
 	int id=0;
     long clk = 0;
     long retired = 0;
+    long fetched = 0;  // instructions taken from the trace, fast-forwarded ones too
+    long requests = 0;  // reads and writes sent to memory
+    long reads_served = 0;
+    long read_latency = 0;  // of the reads served, in memory cycles
+    long finished_clk = 0;  // the cycle the core finished its trace in, 0 until it has
     function<bool(Request)> send;
 
     Processor(const Config& configs, const char* trace_fname, function<bool(Request)> send);
 	Processor(const Config& configs, const char* trace_fname, function<bool(Request)> send, int id);
 	int getID();
 	void tick();
+    bool is_stalled();
+    void skip(long cycles);
+    void fast_forward(long insts);
     void receive(Request& req);
     double calc_ipc();
     bool finished();
-    function<void(Request&)> callback; 
+    Callback callback;
 
 private:
     Trace trace;
@@ -90,6 +225,8 @@ private:
     long req_addr;
     Request::Type req_type;
     bool more_reqs;
+    bool dependent_reads;
+    long blocking_read = -1;  // read that the next one waits for, if dependent
 
     ScalarStat memory_access_cycles;
     ScalarStat cpu_inst;
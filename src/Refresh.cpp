@@ -250,6 +250,13 @@ void Refresh<DSARP>::tick_ref() {
   if ((clk - refreshed) >= refresh_interval)
     inject_refresh(b_ref_rank);
 }
+
+// DARP/DSARP may pull in refreshes on any idle cycle (and draw a random bank
+// to do so), so there is no cycle we can safely skip over
+template<>
+long Refresh<DSARP>::get_next_clk() {
+  return clk + 1;
+}
 /**** End DSARP specialization ****/
 
 } /* namespace ramulator */
@@ -84,6 +84,11 @@ public:
     }
   }
 
+  // Earliest clk at which tick_ref() will inject a refresh
+  long get_next_clk() {
+    return refreshed + ctrl->channel->spec->speed_entry.nREFI;
+  }
+
 private:
   // Keeping track of refresh status of every bank: + means ahead of schedule, - means behind schedule
   vector<vector<int>*> bank_refresh_backlog;
@@ -99,12 +104,12 @@ private:
   // Refresh based on the specified address
   void refresh_target(Controller<T>* ctrl, int rank, int bank, int sa)
   {
-    vector<int> addr_vec(int(T::Level::MAX), -1);
+    AddrVec addr_vec(int(T::Level::MAX), -1);
     addr_vec[0] = ctrl->channel->id;
     addr_vec[1] = rank;
     addr_vec[2] = bank;
     addr_vec[3] = sa;
-    Request req(addr_vec, Request::Type::REFRESH, NULL);
+    Request req(addr_vec, Request::Type::REFRESH, Callback());
     bool res = ctrl->enqueue(req);
     assert(res);
   }
@@ -133,6 +138,7 @@ private:
 // where to look for these definitions when controller calls them!
 template<> Refresh<DSARP>::Refresh(Controller<DSARP>* ctrl);
 template<> void Refresh<DSARP>::tick_ref();
+template<> long Refresh<DSARP>::get_next_clk();
 
 } /* namespace ramulator */
 
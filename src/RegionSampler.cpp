@@ -0,0 +1,168 @@
+#include "RegionSampler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace ramulator;
+
+RegionSampler::RegionSampler(const Config& configs, const vector<Processor*>& cores,
+        double cycle_ns, int request_bytes)
+    : cores(cores), cycle_ns(cycle_ns), request_bytes(request_bytes)
+{
+    load(configs["regions"].c_str());
+    warmup = configs.contains("region_warmup") ? atol(configs["region_warmup"].c_str()) : 1000000;
+
+    starts.resize(cores.size());
+    results.resize(regions.size(), vector<Result>(cores.size()));
+
+    regions_simulated
+        .name("regions_simulated")
+        .desc("Number of trace regions simulated in detail")
+        .precision(0)
+        ;
+    regions_simulated = 0;
+
+    weighted_ipc
+        .init(cores.size())
+        .name("region_weighted_ipc")
+        .desc("IPC per core, from the CPI of the regions combined by weight")
+        .precision(4)
+        ;
+    weighted_bandwidth
+        .init(cores.size())
+        .name("region_weighted_bandwidth")
+        .desc("Memory bandwidth per core in GB/s, combined over the regions by weight")
+        .precision(4)
+        ;
+    weighted_read_latency
+        .init(cores.size())
+        .name("region_weighted_read_latency")
+        .desc("Read latency per core in memory cycles, combined over the regions by weight")
+        .precision(4)
+        ;
+
+    start_region();
+}
+
+void RegionSampler::load(const char* fname)
+{
+    ifstream file(fname);
+    if (!file.good()) {
+        cerr << "Bad region file: " << fname << endl;
+        exit(1);
+    }
+    string line;
+    for (int line_num = 1; getline(file, line); line_num++) {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos == string::npos || line[pos] == '#')
+            continue;
+        Region region;
+        istringstream fields(line);
+        if (!(fields >> region.start >> region.length >> region.weight)
+                || region.start < 0 || region.length <= 0 || region.weight < 0) {
+            cerr << "Bad region in line " << line_num << " of " << fname << ": " << line << endl;
+            exit(1);
+        }
+        regions.push_back(region);
+    }
+    if (regions.empty()) {
+        cerr << "No regions in region file: " << fname << endl;
+        exit(1);
+    }
+    sort(regions.begin(), regions.end(),
+        [] (const Region& a, const Region& b) {return a.start < b.start;});
+}
+
+/*
+ * fast-forward the cores to the warmup before the next region. Regions that
+ * overlap, or that are closer together than the warmup, get a shorter one.
+ */
+void RegionSampler::start_region()
+{
+    const Region& region = regions[next];
+    for (size_t c = 0; c < cores.size(); c++) {
+        Processor* core = cores[c];
+        long skip = region.start - warmup - core->fetched;
+        if (skip > 0)
+            core->fast_forward(skip);
+        starts[c].phase = Phase::Warmup;
+    }
+    printf("region %zu: fast-forwarded to instruction %ld, warming up until %ld\n",
+        next, cores[0]->fetched, region.start);
+}
+
+void RegionSampler::tick()
+{
+    if (done())
+        return;
+
+    const Region& region = regions[next];
+    bool all_done = true;
+    for (size_t c = 0; c < cores.size(); c++) {
+        Processor* core = cores[c];
+        Start& start = starts[c];
+        Result& result = results[next][c];
+
+        if (start.phase == Phase::Warmup && core->fetched >= region.start)
+            start = {Phase::Detail, core->clk, core->retired,
+                core->requests, core->reads_served, core->read_latency};
+
+        if (start.phase == Phase::Detail && core->fetched >= region.start + region.length) {
+            long cycles = core->clk - start.clk;
+            long insts = core->retired - start.retired;
+            long reads = core->reads_served - start.reads_served;
+            result.valid = cycles > 0 && insts > 0;
+            if (result.valid) {
+                result.cpi = double(cycles) / insts;
+                result.bandwidth = double(core->requests - start.requests) * request_bytes / (cycles * cycle_ns);
+                result.read_latency = reads ? double(core->read_latency - start.read_latency) / reads : 0;
+            }
+            start.phase = Phase::Done;
+        }
+
+        // the trace ended before the region did
+        if (start.phase != Phase::Done && core->finished()) {
+            result.valid = false;
+            start.phase = Phase::Done;
+        }
+
+        all_done = all_done && start.phase == Phase::Done;
+    }
+
+    if (!all_done)
+        return;
+    regions_simulated++;
+    next++;
+    if (!done())
+        start_region();
+}
+
+void RegionSampler::finish()
+{
+    for (size_t c = 0; c < cores.size(); c++) {
+        double weights = 0, cpi = 0, bandwidth = 0, read_latency = 0;
+        for (size_t r = 0; r < next; r++) {
+            const Result& result = results[r][c];
+            if (!result.valid) {
+                printf("region %zu on core %zu: not simulated to its end\n", r, c);
+                continue;
+            }
+            printf("region %zu on core %zu: weight %g ipc %.4f bandwidth %.4f GB/s read latency %.2f\n",
+                r, c, regions[r].weight, 1 / result.cpi, result.bandwidth, result.read_latency);
+            double weight = regions[r].weight;
+            weights += weight;
+            cpi += weight * result.cpi;
+            bandwidth += weight * result.bandwidth;
+            read_latency += weight * result.read_latency;
+        }
+        // the weights of the regions simulated may not add up to one
+        if (weights > 0) {
+            weighted_ipc[c] = weights / cpi;
+            weighted_bandwidth[c] = bandwidth / weights;
+            weighted_read_latency[c] = read_latency / weights;
+        }
+    }
+}
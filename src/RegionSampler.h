@@ -0,0 +1,91 @@
+#ifndef __REGIONSAMPLER_H
+#define __REGIONSAMPLER_H
+
+#include "Config.h"
+#include "Processor.h"
+#include "Statistics.h"
+#include <vector>
+
+namespace ramulator
+{
+
+/* Simulates only some regions of the cpu traces, SimPoint style, and
+ * combines their results by weight.
+ *
+ * The region file (config option regions) has one region per line:
+ *   <start instruction> <length in instructions> <weight>
+ * and lines starting with # are skipped. Before each region the cores are
+ * fast-forwarded through the trace without timing to region_warmup
+ * instructions ahead of its start, and are then simulated in detail so
+ * that the queues, row buffers and window are warm when the region starts.
+ *
+ * Each core is measured from the cycle it reaches the start of a region to
+ * the cycle it reaches the end. A core that is done keeps running until
+ * all cores are, so the others still see its memory traffic, and then all
+ * cores move on to the next region together.
+ */
+class RegionSampler
+{
+public:
+    struct Region {
+        long start;
+        long length;
+        double weight;
+    };
+
+    // cycle_ns is the length of a cpu cycle, request_bytes the size of a
+    // memory request
+    RegionSampler(const Config& configs, const std::vector<Processor*>& cores,
+        double cycle_ns, int request_bytes);
+
+    // Call after every cpu cycle: moves the cores on through the regions
+    void tick();
+
+    bool done() const {return next == regions.size();}
+
+    // Combine the regions simulated into the stats
+    void finish();
+
+private:
+    std::vector<Region> regions;
+    long warmup;
+    std::vector<Processor*> cores;
+    double cycle_ns;
+    int request_bytes;
+    size_t next = 0;  // region being simulated
+
+    enum class Phase {
+        Warmup, Detail, Done
+    };
+
+    // a core at the start of the region
+    struct Start {
+        Phase phase;
+        long clk;
+        long retired;
+        long requests;
+        long reads_served;
+        long read_latency;
+    };
+    std::vector<Start> starts;
+
+    struct Result {
+        bool valid;
+        double cpi;
+        double bandwidth;  // GB/s
+        double read_latency;  // memory cycles
+    };
+    std::vector<std::vector<Result>> results;  // by region, then core
+
+    ScalarStat regions_simulated;
+    VectorStat weighted_ipc;
+    VectorStat weighted_bandwidth;
+    VectorStat weighted_read_latency;
+
+    void load(const char* fname);
+    void start_region();
+};
+
+} /*namespace ramulator*/
+
+#endif /*__REGIONSAMPLER_H*/
@@ -0,0 +1,189 @@
+#ifndef __REPLAYQUEUE_H
+#define __REPLAYQUEUE_H
+
+#include "Config.h"
+#include "Request.h"
+#include "Statistics.h"
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+namespace ramulator
+{
+
+// The frontend of an open-loop replay of a timed dram trace. Requests arrive
+// at the cycles of their timestamps whether or not memory keeps up, any
+// number of them in a cycle, and wait here until the controller of their
+// channel takes them. There is a queue for the reads and one for the writes
+// of each channel, so that a full queue in one controller holds up neither
+// the others nor the other type; the oldest request that can go goes first.
+// A read still waits for the older writes to its line in its channel, so it
+// reaches the controller after them and the controller forwards their data.
+// The wait in the frontend is reported on its own: the controller latency
+// only starts once memory takes a request.
+class ReplayQueue
+{
+public:
+    // Timestamps in ns or memory cycles; injection_rate in the config
+    // scales them, 2 arrives twice as fast and 0.5 half as fast. Lines are
+    // 2^tx_bits bytes.
+    ReplayQueue(const Config& configs, int channels, int tx_bits, double clk_ns, bool in_ns)
+        : queues(2 * channels), write_lines(channels, AddrCounter(initial_lines)),
+          lines_capacity(channels, int(initial_lines)), tx_bits(tx_bits)
+    {
+        double rate = configs.contains("injection_rate") ? atof(configs["injection_rate"].c_str()) : 1;
+        if (rate <= 0) {
+            std::cerr << "injection_rate must be positive: " << configs["injection_rate"] << std::endl;
+            exit(1);
+        }
+        cycles_per_unit = (in_ns ? 1 / clk_ns : 1) / rate;
+
+        queueing_delay_avg
+            .name("frontend_queueing_delay_avg")
+            .desc("The average memory cycles a request waited in the frontend before memory took it")
+            .precision(6)
+            ;
+        read_queueing_delay_avg
+            .name("frontend_read_queueing_delay_avg")
+            .desc("The average memory cycles a read request waited in the frontend before memory took it")
+            .precision(6)
+            ;
+        write_queueing_delay_avg
+            .name("frontend_write_queueing_delay_avg")
+            .desc("The average memory cycles a write request waited in the frontend before memory took it")
+            .precision(6)
+            ;
+        queueing_delay_max
+            .name("frontend_queueing_delay_max")
+            .desc("The most memory cycles a request waited in the frontend")
+            .precision(0)
+            ;
+        queue_length_max
+            .name("frontend_queue_length_max")
+            .desc("The most requests waiting in the frontend at once")
+            .precision(0)
+            ;
+    }
+
+    // The memory cycle that a request stamped with time arrives in
+    long arrival(long time) const {return long(time * cycles_per_unit);}
+
+    void push(const Request& req, int channel, long arrive)
+    {
+        bool is_write = req.type == Request::Type::WRITE;
+        if (is_write)
+            add_write_line(channel, req.addr >> tx_bits);
+        queues[2 * channel + is_write].push_back({req, arrive, pushed++});
+        waiting++;
+        max_waiting = std::max(max_waiting, waiting);
+    }
+
+    bool empty() const {return !waiting;}
+
+    // Offer the waiting requests to send(), oldest first, until each queue
+    // is empty or has been turned down once in this cycle. A read behind an
+    // older write to its line is not offered until that write has gone.
+    template<typename Send>
+    void send(long clk, Send send)
+    {
+        blocked.assign(queues.size(), false);
+        while (waiting) {
+            std::deque<Waiting>* oldest = NULL;
+            for (size_t i = 0; i < queues.size(); i++)
+                if (!blocked[i] && queues[i].size() && (!oldest || queues[i].front().seq < oldest->front().seq)
+                        && !(i % 2 == 0 && behind_write(i / 2, queues[i].front())))
+                    oldest = &queues[i];
+            if (!oldest)
+                return;
+            Waiting& head = oldest->front();
+            if (!send(head.req)) {
+                blocked[oldest - queues.data()] = true;
+                continue;
+            }
+            long delay = clk - head.arrive;
+            bool is_read = head.req.type == Request::Type::READ;
+            if (!is_read)
+                write_lines[(oldest - queues.data()) / 2].erase(head.req.addr >> tx_bits);
+            delay_sum[is_read] += delay;
+            sent[is_read]++;
+            max_delay = std::max(max_delay, delay);
+            oldest->pop_front();
+            waiting--;
+        }
+    }
+
+    void finish()
+    {
+        long all = sent[0] + sent[1];
+        queueing_delay_avg = all ? double(delay_sum[0] + delay_sum[1]) / all : 0;
+        read_queueing_delay_avg = sent[1] ? double(delay_sum[1]) / sent[1] : 0;
+        write_queueing_delay_avg = sent[0] ? double(delay_sum[0]) / sent[0] : 0;
+        queueing_delay_max = max_delay;
+        queue_length_max = max_waiting;
+    }
+
+private:
+    struct Waiting {
+        Request req;
+        long arrive;
+        long seq;  // order of arrival
+    };
+
+    double cycles_per_unit;
+    std::vector<std::deque<Waiting>> queues;  // by channel, reads then writes
+    std::vector<bool> blocked;  // turned down in this cycle
+    // by channel, the lines of the waiting writes; each table grows with the
+    // write queue of its channel, so replaying allocates nothing once it fits
+    static const int initial_lines = 64;
+    std::vector<AddrCounter> write_lines;
+    std::vector<int> lines_capacity;
+    int tx_bits;
+    long pushed = 0;
+    long waiting = 0;
+    long max_waiting = 0;
+
+    // indexed by is_read
+    long delay_sum[2] = {0, 0};
+    long sent[2] = {0, 0};
+    long max_delay = 0;
+
+    ScalarStat queueing_delay_avg;
+    ScalarStat read_queueing_delay_avg;
+    ScalarStat write_queueing_delay_avg;
+    ScalarStat queueing_delay_max;
+    ScalarStat queue_length_max;
+
+    void add_write_line(int channel, long line)
+    {
+        const std::deque<Waiting>& writes = queues[2 * channel + 1];
+        if (int(writes.size()) == lines_capacity[channel]) {
+            lines_capacity[channel] *= 2;
+            write_lines[channel] = AddrCounter(lines_capacity[channel]);
+            for (const Waiting& write : writes)
+                write_lines[channel].insert(write.req.addr >> tx_bits);
+        }
+        write_lines[channel].insert(line);
+    }
+
+    // Whether an older write to the line of the read is still waiting; the
+    // write queue is only searched when one to the line waits at all
+    bool behind_write(int channel, const Waiting& read) const
+    {
+        long line = read.req.addr >> tx_bits;
+        if (!write_lines[channel].count(line))
+            return false;
+        for (const Waiting& write : queues[2 * channel + 1]) {
+            if (write.seq > read.seq)
+                break;
+            if ((write.req.addr >> tx_bits) == line)
+                return true;
+        }
+        return false;
+    }
+};
+
+} /*namespace ramulator*/
+
+#endif /*__REPLAYQUEUE_H*/
@@ -2,20 +2,102 @@
 #define __REQUEST_H
 
 #include <vector>
-#include <functional>
+#include <list>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 
 using namespace std;
 
 namespace ramulator
 {
 
+class Request;
+
+// Address of a request split into one index per level of the DRAM hierarchy
+// (e.g., Channel, Rank, Bank, Row, Column). It is stored inline, so copying a
+// request never touches the heap; the capacity covers Level::MAX of every
+// standard.
+class AddrVec
+{
+public:
+    static const int capacity = 6;
+
+    AddrVec() {fill_n(vec, capacity, -1);}
+    AddrVec(int n, int val) : AddrVec() {resize(n, val);}
+
+    void resize(int n, int val = -1) {
+        assert(n <= capacity);
+        for (int i = len; i < n; i++)
+            vec[i] = val;
+        len = n;
+    }
+
+    int size() const {return len;}
+    bool empty() const {return !len;}
+
+    int* data() {return vec;}
+    const int* data() const {return vec;}
+    int* begin() {return vec;}
+    const int* begin() const {return vec;}
+    int* end() {return vec + len;}
+    const int* end() const {return vec + len;}
+
+    int& operator[](int i) {return vec[i];}
+    const int& operator[](int i) const {return vec[i];}
+
+private:
+    int vec[capacity];
+    int len = 0;
+};
+
+// Handle to the function a request calls back when it has been served. It is
+// a function pointer plus the object it is called on, so unlike a std::function
+// holding a bound member function, copying it never allocates. The object must
+// outlive the requests that carry the handle.
+class Callback
+{
+public:
+    Callback() {}
+
+    // Call (*obj)(req), e.g., for a lambda
+    template <typename F>
+    explicit Callback(F* obj) : fn(&call<F>), obj(obj) {}
+
+    // Call (obj->*method)(req)
+    template <typename C, void (C::*method)(Request&)>
+    static Callback bind(C* obj) {
+        Callback callback;
+        callback.fn = &call_method<C, method>;
+        callback.obj = obj;
+        return callback;
+    }
+
+    void operator()(Request& req) const {
+        if (fn)
+            fn(obj, req);
+    }
+
+private:
+    void (*fn)(void*, Request&) = NULL;
+    void* obj = NULL;
+
+    template <typename F>
+    static void call(void* obj, Request& req) {(*static_cast<F*>(obj))(req);}
+
+    template <typename C, void (C::*method)(Request&)>
+    static void call_method(void* obj, Request& req) {(static_cast<C*>(obj)->*method)(req);}
+};
+
 class Request
 {
 public:
     bool is_first_command;
     long addr;
     // long addr_row;
-    vector<int> addr_vec;
+    AddrVec addr_vec;
     // specify which core this request sent from, for virtual address translation
     int coreid;
 
@@ -32,23 +114,277 @@ public:
 
     long arrive = -1;
     long depart;
-    function<void(Request&)> callback; // call back with more info
+    Callback callback; // call back with more info
 
     Request(long addr, Type type, int coreid = 0)
-        : is_first_command(true), addr(addr), coreid(coreid), type(type),
-      callback([](Request& req){}) {}
+        : is_first_command(true), addr(addr), coreid(coreid), type(type) {}
 
-    Request(long addr, Type type, function<void(Request&)> callback, int coreid = 0)
+    Request(long addr, Type type, Callback callback, int coreid = 0)
         : is_first_command(true), addr(addr), coreid(coreid), type(type), callback(callback) {}
 
-    Request(vector<int>& addr_vec, Type type, function<void(Request&)> callback, int coreid = 0)
+    Request(const AddrVec& addr_vec, Type type, Callback callback, int coreid = 0)
         : is_first_command(true), addr_vec(addr_vec), coreid(coreid), type(type), callback(callback) {}
 
     Request()
         : is_first_command(true), coreid(0) {}
 };
 
+// Fixed-capacity FIFO of requests that a controller queue scans and erases
+// from at any position. The requests live in one contiguous array of slots,
+// linked in arrival order; erased slots go to a free list and are reused by
+// the next push_back, so the queue never allocates after construction.
+class RequestQueue
+{
+    struct Slot {
+        Request req;
+        Slot* prev;
+        Slot* next;
+    };
+
+public:
+    class iterator
+    {
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef Request value_type;
+        typedef ptrdiff_t difference_type;
+        typedef Request* pointer;
+        typedef Request& reference;
+
+        iterator() {}
+        explicit iterator(Slot* slot) : slot(slot) {}
+
+        Request& operator*() const {return slot->req;}
+        Request* operator->() const {return &slot->req;}
+        iterator& operator++() {slot = slot->next; return *this;}
+        iterator operator++(int) {iterator old = *this; slot = slot->next; return old;}
+        bool operator==(const iterator& other) const {return slot == other.slot;}
+        bool operator!=(const iterator& other) const {return slot != other.slot;}
+
+    private:
+        friend class RequestQueue;
+        Slot* slot = NULL;
+    };
+
+    explicit RequestQueue(int capacity) : slots(capacity) {
+        for (int i = capacity - 1; i >= 0; i--) {
+            slots[i].next = free_head;
+            free_head = &slots[i];
+        }
+    }
+    RequestQueue(const RequestQueue&) = delete;
+    RequestQueue& operator=(const RequestQueue&) = delete;
+
+    int capacity() const {return slots.size();}
+    unsigned int size() const {return count;}
+    bool empty() const {return !count;}
+
+    iterator begin() {return iterator(head);}
+    iterator end() {return iterator();}
+    Request& front() {return head->req;}
+    Request& back() {return tail->req;}
+
+    // Position of a request in the slot array, for keeping data alongside it
+    int index(iterator itr) const {return itr.slot - slots.data();}
+
+    iterator push_back(const Request& req) {
+        assert(free_head);
+        Slot* slot = free_head;
+        free_head = slot->next;
+        slot->req = req;
+        slot->prev = tail;
+        slot->next = NULL;
+        if (tail)
+            tail->next = slot;
+        else
+            head = slot;
+        tail = slot;
+        count++;
+        return iterator(slot);
+    }
+
+    void pop_back() {erase(iterator(tail));}
+
+    iterator erase(iterator itr) {
+        Slot* slot = itr.slot;
+        Slot* next = slot->next;
+        if (slot->prev)
+            slot->prev->next = slot->next;
+        else
+            head = slot->next;
+        if (slot->next)
+            slot->next->prev = slot->prev;
+        else
+            tail = slot->prev;
+        slot->next = free_head;
+        free_head = slot;
+        count--;
+        return iterator(next);
+    }
+
+private:
+    vector<Slot> slots;  // never resized, so the links stay valid
+    Slot* head = NULL;
+    Slot* tail = NULL;
+    Slot* free_head = NULL;
+    unsigned int count = 0;
+};
+
+// Multiset of request addresses in an open-addressed hash table with linear
+// probing. It holds at most capacity distinct addresses, and the table is
+// sized to stay at most half full, so lookups, inserts and erases are O(1).
+class AddrCounter
+{
+public:
+    explicit AddrCounter(int capacity) {
+        int bits = 2;
+        while ((1 << bits) < 2 * capacity)
+            bits++;
+        shift = 64 - bits;
+        mask = (1 << bits) - 1;
+        keys.resize(1 << bits);
+        counts.resize(1 << bits, 0);
+    }
+
+    // Number of times addr has been inserted and not yet erased
+    int count(long addr) const {
+        for (int i = hash(addr); counts[i]; i = (i + 1) & mask)
+            if (keys[i] == addr)
+                return counts[i];
+        return 0;
+    }
+
+    void insert(long addr) {
+        int i = hash(addr);
+        for (; counts[i]; i = (i + 1) & mask)
+            if (keys[i] == addr) {
+                counts[i]++;
+                return;
+            }
+        used++;
+        assert(used <= (mask + 1) / 2);
+        keys[i] = addr;
+        counts[i] = 1;
+    }
+
+    void erase(long addr) {
+        int i = hash(addr);
+        while (keys[i] != addr) {
+            assert(counts[i]);
+            i = (i + 1) & mask;
+        }
+        assert(counts[i]);
+        if (--counts[i])
+            return;
+        used--;
+        // shift back the entries of the probe run that would no longer be
+        // reachable from their home slot
+        for (int j = (i + 1) & mask; counts[j]; j = (j + 1) & mask) {
+            int home = hash(keys[j]);
+            if (((j - home) & mask) < ((j - i) & mask))
+                continue;
+            keys[i] = keys[j];
+            counts[i] = counts[j];
+            counts[j] = 0;
+            i = j;
+        }
+    }
+
+private:
+    vector<long> keys;
+    vector<int> counts;  // 0 marks an empty slot
+    int shift;
+    int mask;
+    int used = 0;
+
+    int hash(long addr) const {return int((uint64_t(addr) * 0x9E3779B97F4A7C15ull) >> shift);}
+};
+
+// Slab of equally sized blocks that are recycled through a free list. Each
+// controller owns one and takes the nodes of its request queues from it, so
+// once the slabs are warm, moving a request through the controller does not
+// allocate.
+class RequestPool
+{
+public:
+    RequestPool() {}
+    RequestPool(const RequestPool&) = delete;
+    RequestPool& operator=(const RequestPool&) = delete;
+
+    ~RequestPool() {
+        for (auto slab : slabs)
+            ::operator delete(slab);
+    }
+
+    void* allocate(size_t size) {
+        if (!block)
+            block = max(size, sizeof(Block));
+        assert(size <= block); // all queues hold the same node type
+        if (!free_list)
+            grow();
+        Block* b = free_list;
+        free_list = b->next;
+        return b;
+    }
+
+    void deallocate(void* p) {
+        Block* b = static_cast<Block*>(p);
+        b->next = free_list;
+        free_list = b;
+    }
+
+    long slab_count() const {return slabs.size();}
+
+private:
+    struct Block {Block* next;};
+    static const int blocks_per_slab = 64;
+
+    size_t block = 0;
+    Block* free_list = NULL;
+    vector<char*> slabs;
+
+    void grow() {
+        char* slab = static_cast<char*>(::operator new(block * blocks_per_slab));
+        slabs.push_back(slab);
+        for (int i = blocks_per_slab - 1; i >= 0; i--)
+            deallocate(slab + i * block);
+    }
+};
+
+// Allocator that hands out single nodes from a RequestPool
+template <typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    RequestPool* pool;
+
+    PoolAllocator(RequestPool* pool) : pool(pool) {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) {
+        if (n == 1)
+            return static_cast<T*>(pool->allocate(sizeof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n == 1)
+            pool->deallocate(p);
+        else
+            ::operator delete(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b) {return a.pool == b.pool;}
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b) {return a.pool != b.pool;}
+
+typedef list<Request, PoolAllocator<Request>> RequestList;
+
 } /*namespace ramulator*/
 
 #endif /*__REQUEST_H*/
-
@@ -121,7 +121,7 @@ void SALP::init_prereq()
                 switch (int(node->state)){
                     case int(State::Closed): return Command::ACT;
                     case int(State::Opened):
-                        if (node->children[id]->row_state.find(id) != node->children[id]->row_state.end()) return cmd;
+                        if (node->children[id]->row_state.is_open(id)) return cmd;
                         else return Command::PREB;
                     default: assert(false);}};
             prereq[int(Level::Bank)][int(Command::WR)] = prereq[int(Level::Bank)][int(Command::RD)];
@@ -138,7 +138,7 @@ void SALP::init_prereq()
                 switch (int(node->state)){
                     case int(State::Closed): return Command::ACT;
                     case int(State::Opened):
-                        if (node->row_state.find(id) != node->row_state.end()) return cmd;
+                        if (node->row_state.is_open(id)) return cmd;
                         else if (node->row_state.size()) return Command::PRE; // precharge this subarray
                         else return Command::PRE_OTHER; // precharge the other subarray
                     default: assert(false);}};
@@ -157,10 +157,10 @@ void SALP::init_prereq()
                 switch (int(node->state)){
                     case int(State::Closed): return Command::ACT;
                     case int(State::Opened):
-                        if (node->row_state.find(id) != node->row_state.end()) return Command::SASEL;
+                        if (node->row_state.is_open(id)) return Command::SASEL;
                         else return Command::PRE;
                     case int(State::Selected):
-                        if (node->row_state.find(id) != node->row_state.end()) return cmd;
+                        if (node->row_state.is_open(id)) return cmd;
                         else return Command::PRE;
                     default: assert(false);
                 }};
@@ -207,7 +207,7 @@ void SALP::init_rowhit()
                 switch (int(node->state)){
                     case int(State::Closed): return false;
                     case int(State::Opened):
-                        if (node->children[id]->row_state.find(id) != node->children[id]->row_state.end()) return true;
+                        if (node->children[id]->row_state.is_open(id)) return true;
                         else return false;
                     default: assert(false);
                 }};
@@ -220,7 +220,7 @@ void SALP::init_rowhit()
                 switch (int(node->state)){
                     case int(State::Closed): return false;
                     case int(State::Opened):
-                        if (node->row_state.find(id) != node->row_state.end()) return true;
+                        if (node->row_state.is_open(id)) return true;
                         else return false;
                     default: assert(false);
                 }};
@@ -234,10 +234,10 @@ void SALP::init_rowhit()
                     case int(State::Closed): return false;
                     case int(State::Opened):
                         // opened but not selected still counts as a row hit
-                        if (node->row_state.find(id) != node->row_state.end()) return true;
+                        if (node->row_state.is_open(id)) return true;
                         else return false;
                     case int(State::Selected):
-                        if (node->row_state.find(id) != node->row_state.end()) return true;
+                        if (node->row_state.is_open(id)) return true;
                         else return false;
                     default: assert(false);
                 }};
@@ -295,7 +295,7 @@ void SALP::init_lambda()
         case int(Type::SALP_1):
             lambda[int(Level::Bank)][int(Command::ACT)] = [] (DRAM<SALP>* node, int id) {
                 node->state = State::Opened;
-                node->children[id]->row_state[id] = State::Opened;};
+                node->children[id]->row_state.open(id);};
             lambda[int(Level::Bank)][int(Command::PRE)] = [] (DRAM<SALP>* node, int id) {
                 node->state = State::Closed;
                 node->children[id]->row_state.clear();};
@@ -321,7 +321,7 @@ void SALP::init_lambda()
         case int(Type::SALP_2):
             lambda[int(Level::SubArray)][int(Command::ACT)] = [] (DRAM<SALP>* node, int id) {
                 node->state = State::Opened;
-                node->row_state[id] = State::Opened;};
+                node->row_state.open(id);};
             lambda[int(Level::SubArray)][int(Command::PRE)] = [] (DRAM<SALP>* node, int id) {
                 node->state = State::Closed;
                 node->row_state.clear();};
@@ -350,7 +350,7 @@ void SALP::init_lambda()
         case int(Type::MASA):
             lambda[int(Level::SubArray)][int(Command::ACT)] = [] (DRAM<SALP>* node, int id) {
                 node->state = State::Selected;
-                node->row_state[id] = State::Opened;
+                node->row_state.open(id);
                 for (auto sa : node->parent->children)
                     if (sa != node && sa->state == State::Selected) {
                         sa->state = State::Opened;
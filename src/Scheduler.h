@@ -9,6 +9,8 @@
 #include <list>
 #include <functional>
 #include <cassert>
+#include <limits>
+#include <cstdint>
 
 using namespace std;
 
@@ -18,6 +20,9 @@ namespace ramulator
 template <typename T>
 class Controller;
 
+template <typename T>
+class RowTable;
+
 template <typename T>
 class Scheduler
 {
@@ -32,54 +37,38 @@ public:
 
     Scheduler(Controller<T>* ctrl) : ctrl(ctrl) {}
 
-    list<Request>::iterator get_head(list<Request>& q)
-    {
-        if (!q.size())
-            return q.end();
-
-        auto head = q.begin();
-        for (auto itr = next(q.begin(), 1); itr != q.end(); itr++)
-            head = compare[int(type)](head, itr);
+    typedef typename Controller<T>::Queue Queue;
 
-        return head;
+    RequestQueue::iterator get_head(Queue& queue)
+    {
+        return pick[int(type)](queue);
     }
 
 private:
-    typedef list<Request>::iterator ReqIter;
-    function<ReqIter(ReqIter, ReqIter)> compare[int(Type::MAX)] = {
+    // Requests are queued in arrival order, so the oldest request that meets
+    // a criterion is the first one found. Readiness is cached by the
+    // controller, so the scan stops at the first ready request without
+    // decoding the ones behind it.
+    typedef RequestQueue::iterator ReqIter;
+    function<ReqIter(Queue&)> pick[int(Type::MAX)] = {
         // FCFS
-        [this] (ReqIter req1, ReqIter req2) {
-            if (req1->arrive <= req2->arrive) return req1;
-            return req2;},
+        [this] (Queue& queue) {
+            return queue.q.begin();},
 
         // FRFCFS
-        [this] (ReqIter req1, ReqIter req2) {
-            bool ready1 = this->ctrl->is_ready(req1);
-            bool ready2 = this->ctrl->is_ready(req2);
-
-            if (ready1 ^ ready2) {
-                if (ready1) return req1;
-                return req2;
-            }
-
-            if (req1->arrive <= req2->arrive) return req1;
-            return req2;},
+        [this] (Queue& queue) {
+            for (auto req = queue.q.begin(); req != queue.q.end(); req++)
+                if (this->ctrl->is_ready(queue, req))
+                    return req;
+            return queue.q.begin();},
 
         // FRFCFS_CAP
-        [this] (ReqIter req1, ReqIter req2) {
-            bool ready1 = this->ctrl->is_ready(req1);
-            bool ready2 = this->ctrl->is_ready(req2);
-
-            ready1 = ready1 && (this->ctrl->rowtable->get_hits(req1->addr_vec) <= this->cap);
-            ready2 = ready2 && (this->ctrl->rowtable->get_hits(req2->addr_vec) <= this->cap);
-
-            if (ready1 ^ ready2) {
-                if (ready1) return req1;
-                return req2;
-            }
-
-            if (req1->arrive <= req2->arrive) return req1;
-            return req2;}
+        [this] (Queue& queue) {
+            for (auto req = queue.q.begin(); req != queue.q.end(); req++)
+                if (this->ctrl->is_ready(queue, req)
+                        && this->ctrl->rowtable->get_hits(req->addr_vec) <= this->cap)
+                    return req;
+            return queue.q.begin();}
     };
 };
 
@@ -98,37 +87,56 @@ public:
 
     RowPolicy(Controller<T>* ctrl) : ctrl(ctrl) {}
 
-    vector<int> get_victim(typename T::Command cmd)
+    AddrVec get_victim(typename T::Command cmd)
     {
         return policy[int(type)](cmd);
     }
 
+    // Return the earliest clock at which get_victim() could find a victim
+    long get_next_clk(typename T::Command cmd)
+    {
+        long next_clk = numeric_limits<long>::max();
+        if (type == Type::Opened)
+            return next_clk;
+
+        RowTable<T>* rowtable = this->ctrl->rowtable;
+        for (long i = rowtable->find_open(0); i >= 0; i = rowtable->find_open(i + 1)) {
+            long clk = this->ctrl->channel->get_next(cmd, rowtable->rowgroups[i].data());
+            if (type == Type::Timeout)
+                clk = max(clk, rowtable->table[i].timestamp + timeout);
+            next_clk = min(next_clk, clk);
+        }
+        return next_clk;
+    }
+
 private:
-    function<vector<int>(typename T::Command)> policy[int(Type::MAX)] = {
+    function<AddrVec(typename T::Command)> policy[int(Type::MAX)] = {
         // Closed
-        [this] (typename T::Command cmd) -> vector<int> {
-            for (auto& kv : this->ctrl->rowtable->table) {
-                if (!this->ctrl->is_ready(cmd, kv.first))
+        [this] (typename T::Command cmd) -> AddrVec {
+            RowTable<T>* rowtable = this->ctrl->rowtable;
+            for (long i = rowtable->find_open(0); i >= 0; i = rowtable->find_open(i + 1)) {
+                if (!this->ctrl->is_ready(cmd, rowtable->rowgroups[i]))
                     continue;
-                return kv.first;
+                return rowtable->rowgroups[i];
             }
-            return vector<int>();},
+            return AddrVec();},
 
         // Opened
         [this] (typename T::Command cmd) {
-            return vector<int>();},
+            return AddrVec();},
 
         // Timeout
-        [this] (typename T::Command cmd) -> vector<int> {
-            for (auto& kv : this->ctrl->rowtable->table) {
-                auto& entry = kv.second;
+        [this] (typename T::Command cmd) -> AddrVec {
+            RowTable<T>* rowtable = this->ctrl->rowtable;
+            for (long i = rowtable->find_open(0); i >= 0; i = rowtable->find_open(i + 1)) {
+                auto& entry = rowtable->table[i];
                 if (this->ctrl->clk - entry.timestamp < timeout)
                     continue;
-                if (!this->ctrl->is_ready(cmd, kv.first))
+                if (!this->ctrl->is_ready(cmd, rowtable->rowgroups[i]))
                     continue;
-                return kv.first;
+                return rowtable->rowgroups[i];
             }
-            return vector<int>();}
+            return AddrVec();}
     };
 
 };
@@ -146,61 +154,107 @@ public:
         long timestamp;
     };
 
-    map<vector<int>, Entry> table;
+    // One entry per rowgroup (bank or subarray) of the channel, indexed by
+    // the flattened address of the rowgroup. An entry is only valid while
+    // the bit of its rowgroup is set in the open bitmap.
+    vector<Entry> table;
+    vector<AddrVec> rowgroups; // address vector of each rowgroup
 
-    RowTable(Controller<T>* ctrl) : ctrl(ctrl) {}
+    RowTable(Controller<T>* ctrl) : ctrl(ctrl)
+    {
+        T* spec = ctrl->channel->spec;
+
+        // the channel level is fixed for a controller
+        long size = 1;
+        for (int l = int(T::Level::Row) - 1; l > int(T::Level::Channel); l--) {
+            stride[l] = size;
+            size *= spec->org_entry.count[l];
+        }
+        table.resize(size);
+        open.resize((size + 63) / 64);
+
+        for (long i = 0; i < size; i++) {
+            AddrVec rowgroup(int(T::Level::Row), -1);
+            rowgroup[int(T::Level::Channel)] = ctrl->channel->id;
+            for (int l = int(T::Level::Channel) + 1; l < int(T::Level::Row); l++)
+                rowgroup[l] = (i / stride[l]) % spec->org_entry.count[l];
+            rowgroups.push_back(rowgroup);
+        }
+    }
 
-    void update(typename T::Command cmd, const vector<int>& addr_vec, long clk)
+    void update(typename T::Command cmd, const AddrVec& addr_vec, long clk)
     {
-        auto begin = addr_vec.begin();
-        auto end = begin + int(T::Level::Row);
-        vector<int> rowgroup(begin, end); // bank or subarray
-        int row = *end;
+        long i = get_index(addr_vec, int(T::Level::Row) - 1);
+        int row = addr_vec[int(T::Level::Row)];
 
         T* spec = ctrl->channel->spec;
 
-        if (spec->is_opening(cmd))
-            table.insert({rowgroup, {row, 0, clk}});
+        if (spec->is_opening(cmd) && !is_open(i)) {
+            table[i] = {row, 0, clk};
+            open[i / 64] |= uint64_t(1) << (i % 64);
+        }
 
         if (spec->is_accessing(cmd)) {
             // we are accessing a row -- update its entry
-            auto match = table.find(rowgroup);
-            assert(match != table.end());
-            assert(match->second.row == row);
-            match->second.hits++;
-            match->second.timestamp = clk;
+            assert(is_open(i));
+            assert(table[i].row == row);
+            table[i].hits++;
+            table[i].timestamp = clk;
         } /* accessing */
 
         if (spec->is_closing(cmd)) {
           // we are closing one or more rows -- remove their entries
+          int scope = min(int(spec->scope[int(cmd)]), int(T::Level::Row) - 1);
+          long begin = get_index(addr_vec, scope);
+          long end = begin + (scope > int(T::Level::Channel) ? stride[scope] : table.size());
           int n_rm = 0;
-          int scope = int(spec->scope[int(cmd)]);
-          for (auto it = table.begin(); it != table.end();) {
-            if (equal(begin, begin + scope + 1, it->first.begin())) {
-              n_rm++;
-              it = table.erase(it);
-            }
-            else
-              it++;
+          for (long j = begin; j < end; j++) {
+            if (!is_open(j))
+              continue;
+            n_rm++;
+            open[j / 64] &= ~(uint64_t(1) << (j % 64));
           }
           assert(n_rm > 0);
         } /* closing */
     }
 
-    int get_hits(vector<int>& addr_vec)
+    int get_hits(const AddrVec& addr_vec)
     {
-        auto begin = addr_vec.begin();
-        auto end = begin + int(T::Level::Row);
-
-        vector<int> rowgroup(begin, end);
-        int row = *end;
+        long i = get_index(addr_vec, int(T::Level::Row) - 1);
+        int row = addr_vec[int(T::Level::Row)];
 
-        auto itr = table.find(rowgroup);
-        auto entry = table[rowgroup];
-        if (itr == table.end() || entry.row != row)
+        if (!is_open(i) || table[i].row != row)
             return 0;
 
-        return entry.hits;
+        return table[i].hits;
+    }
+
+    bool is_open(long i) const {return open[i / 64] & (uint64_t(1) << (i % 64));}
+
+    // Return the first rowgroup at or after i that has an open row, or -1
+    long find_open(long i) const
+    {
+        for (long w = i / 64; w < long(open.size()); w++) {
+            uint64_t bits = open[w];
+            if (w == i / 64)
+                bits &= ~uint64_t(0) << (i % 64);
+            if (bits)
+                return w * 64 + __builtin_ctzll(bits);
+        }
+        return -1;
+    }
+
+private:
+    long stride[int(T::Level::MAX)] = {0};
+    vector<uint64_t> open; // bitmap of the rowgroups that have an open row
+
+    // Flattened index of the first rowgroup under the address prefix up to level
+    long get_index(const AddrVec& addr_vec, int level) const
+    {
+        long i = 0;
+        for (int l = int(T::Level::Channel) + 1; l <= level; l++)
+            i += addr_vec[l] * stride[l];
+        return i;
     }
 };
 
@@ -148,11 +148,11 @@ public:
         int refresh_interval = channel->spec->speed_entry.nREFI;
         if (clk - refreshed >= refresh_interval) {
             auto req_type = Request::Type::REFRESH;
-            vector<int> addr_vec(int(T::Level::MAX), -1);
+            AddrVec addr_vec(int(T::Level::MAX), -1);
             addr_vec[0] = channel->id;
             for (auto child : channel->children) {
                 addr_vec[1] = child->id;
-                Request req(addr_vec, req_type, NULL);
+                Request req(addr_vec, req_type, Callback());
                 bool res = enqueue(req);
                 assert(res);
             }
@@ -201,7 +201,7 @@ private:
                     node = node->children[req.addr_vec[i]];
                 assert(int(node->level) == int(T::Level::Row) - 1);
                 if (node->state == T::State::Closed) return T::Command::ACT;
-                else if (node->row_state.find(req.addr_vec[int(T::Level::Row)]) != node->row_state.end()) return cmd;
+                else if (node->row_state.is_open(req.addr_vec[int(T::Level::Row)])) return cmd;
                 else return T::Command::PRE;
             }
             case int(Request::Type::REFRESH):
@@ -163,7 +163,7 @@ void TLDRAM::init_prereq()
                 else
                     return Command::ACTF;
             case int(State::Opened):
-                if (node->row_state.find(id) != node->row_state.end())
+                if (node->row_state.is_open(id))
                     return cmd;
                 if (id % node->spec->segment_ratio)
                     return Command::PRE;
@@ -177,7 +177,7 @@ void TLDRAM::init_prereq()
             case int(State::Closed):
                 return Command::ACTM;
             case int(State::Opened):
-                if (node->row_state.find(id) != node->row_state.end())
+                if (node->row_state.is_open(id))
                     return cmd;
                 return Command::PREM;
             default: assert(false);
@@ -232,7 +232,7 @@ void TLDRAM::init_rowhit()
         switch (int(node->state)) {
             case int(State::Closed): return false;
             case int(State::Opened):
-                if (node->row_state.find(id) != node->row_state.end())
+                if (node->row_state.is_open(id))
                     return true;
                 return false;
             default: assert(false);
@@ -260,15 +260,15 @@ void TLDRAM::init_lambda()
 {
     lambda[int(Level::Bank)][int(Command::ACT)] = [] (DRAM<TLDRAM>* node, int id) {
         node->state = State::Opened;
-        node->row_state[id] = State::Opened;
+        node->row_state.open(id);
     };
     lambda[int(Level::Bank)][int(Command::ACTF)] = [] (DRAM<TLDRAM>* node, int id) {
         node->state = State::Opened;
-        node->row_state[id] = State::Opened;
+        node->row_state.open(id);
     };
     lambda[int(Level::Bank)][int(Command::ACTM)] = [] (DRAM<TLDRAM>* node, int id) {
         node->state = State::Opened;
-        node->row_state[id] = State::Opened;
+        node->row_state.open(id);
     };
     lambda[int(Level::Bank)][int(Command::PRE)] = [] (DRAM<TLDRAM>* node, int id) {
         node->state = State::Closed;
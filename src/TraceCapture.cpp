@@ -0,0 +1,67 @@
+#include "TraceCapture.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+using namespace ramulator;
+
+TraceCapture::TraceCapture(const char* fname)
+    : fname(fname), writer(fname, TraceHeader::Kind::Timed)
+{
+    if (!writer.good()) {
+        std::cerr << "Cannot write capture trace file: " << fname << std::endl;
+        exit(1);
+    }
+    block.reserve(block_size);
+    writer_thread = std::thread(&TraceCapture::write_loop, this);
+}
+
+void TraceCapture::close()
+{
+    if (closed)
+        return;
+    closed = true;
+    hand_over();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        done = true;
+    }
+    changed.notify_all();
+    writer_thread.join();
+
+    if (!writer.close()) {
+        std::cerr << "Cannot write capture trace file: " << fname << std::endl;
+        exit(1);
+    }
+    printf("captured %ld requests to %s\n", captured, fname.c_str());
+}
+
+void TraceCapture::hand_over()
+{
+    captured += block.size();
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] {return full.size() < max_blocks;});
+    full.push_back(std::move(block));
+    guard.unlock();
+    changed.notify_all();
+
+    block = std::vector<Captured>();
+    block.reserve(block_size);
+}
+
+void TraceCapture::write_loop()
+{
+    while (true) {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this] {return !full.empty() || done;});
+        if (full.empty())
+            return;
+        std::vector<Captured> records = std::move(full.front());
+        full.pop_front();
+        guard.unlock();
+        changed.notify_all();
+
+        for (auto& r : records)
+            writer.write_timed(r.clk, r.addr, r.is_write, r.coreid);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef __TRACECAPTURE_H
+#define __TRACECAPTURE_H
+
+#include "Request.h"
+#include "TraceFormat.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ramulator
+{
+
+// Writes the requests that memory accepts, with the memory cycle each one
+// arrived in and its core, to a timed binary trace (see TraceFormat.h). The
+// trace replays in dram mode without the frontend that made the requests.
+// Requests are handed a block at a time to a thread of its own, which encodes
+// and writes them. That thread sleeps between blocks, since a block takes
+// many cycles to fill, and the simulation only waits for it when it is more
+// than max_blocks blocks behind.
+class TraceCapture
+{
+public:
+    static const size_t block_size = 1 << 16;
+    static const size_t max_blocks = 8;
+
+    TraceCapture(const char* fname);
+    ~TraceCapture() {close();}
+
+    TraceCapture(const TraceCapture&) = delete;
+    TraceCapture& operator=(const TraceCapture&) = delete;
+
+    // Capture a read or write after memory accepted it, which set its arrive
+    void record(const Request& req)
+    {
+        if (closed || (req.type != Request::Type::READ && req.type != Request::Type::WRITE))
+            return;
+        block.push_back({req.arrive, req.addr, req.coreid, req.type == Request::Type::WRITE});
+        if (block.size() == block_size)
+            hand_over();
+    }
+
+    // Write what is left and close the trace; later requests are not captured
+    void close();
+
+private:
+    struct Captured {
+        long clk;
+        long addr;
+        int coreid;
+        bool is_write;
+    };
+
+    std::string fname;
+    TraceWriter writer;
+    std::vector<Captured> block;
+    long captured = 0;
+    bool closed = false;
+
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<Captured>> full;  // handed over, not written yet
+    bool done = false;  // no more blocks will come
+    std::thread writer_thread;
+
+    void hand_over();
+    void write_loop();
+};
+
+} /*namespace ramulator*/
+
+#endif /*__TRACECAPTURE_H*/
@@ -0,0 +1,147 @@
+#ifndef __TRACEFORMAT_H
+#define __TRACEFORMAT_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace ramulator
+{
+
+/* Binary trace format
+ *
+ * header: the magic "RAMTRACE", then the version and the kind of trace as
+ *         uint32 in host byte order (see TraceHeader)
+ * records, up to the end of the file:
+ *   cpu:  varint (bubble_cnt << 1 | has_write)
+ *         varint zigzag(read_addr - read_addr of the previous record)
+ *         varint zigzag(write_addr - read_addr), only if has_write
+ *   dram: varint (zigzag(addr - addr of the previous record) << 1 | is_write)
+ *   timed: a dram request with the memory cycle it arrived in and its core
+ *         varint zigzag(clk - clk of the previous record)
+ *         varint (zigzag(addr - addr of the previous record) << 1 | is_write)
+ *         varint zigzag(coreid)
+ *
+ * A varint holds 7 bits per byte, least significant first, and sets the top
+ * bit of every byte but the last. Zigzag maps signed deltas to small unsigned
+ * numbers: 0, -1, 1, -2, ... to 0, 1, 2, 3, ...
+ */
+struct TraceHeader
+{
+    enum class Kind : uint32_t {
+        CPU, DRAM, Timed
+    };
+
+    static const uint32_t current_version = 1;
+
+    char magic[8];
+    uint32_t version;
+    Kind kind;
+
+    TraceHeader() {}
+    TraceHeader(Kind kind) : version(current_version), kind(kind) {
+        memcpy(magic, "RAMTRACE", sizeof(magic));
+    }
+
+    bool is_valid() const {return !memcmp(magic, "RAMTRACE", sizeof(magic));}
+};
+
+inline uint64_t zigzag(long val) {return (uint64_t(val) << 1) ^ uint64_t(val >> 63);}
+inline long unzigzag(uint64_t val) {return long(val >> 1) ^ -long(val & 1);}
+
+// Decode the varint at pos and move pos past it; false if it is cut off by end
+inline bool read_varint(const unsigned char*& pos, const unsigned char* end, uint64_t& val)
+{
+    val = 0;
+    for (int shift = 0; pos < end && shift < 64; shift += 7) {
+        unsigned char byte = *pos++;
+        val |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Writes the records of a binary trace, delta-encoding each address against
+// the one before it
+class TraceWriter
+{
+public:
+    TraceWriter(const char* fname, TraceHeader::Kind kind) : kind(kind)
+    {
+        file = fopen(fname, "wb");
+        if (!file)
+            return;
+        TraceHeader header(kind);
+        fwrite(&header, sizeof(header), 1, file);
+    }
+
+    ~TraceWriter() {close();}
+
+    bool good() const {return file && !ferror(file);}
+
+    // Flush and close the file; whether everything was written
+    bool close()
+    {
+        if (!file)
+            return false;
+        bool written = !ferror(file);
+        written = !fclose(file) && written;
+        file = NULL;
+        return written;
+    }
+
+    void write_cpu(long bubble_cnt, long read_addr, bool has_write, long write_addr)
+    {
+        assert(kind == TraceHeader::Kind::CPU && bubble_cnt >= 0);
+        write_varint((uint64_t(bubble_cnt) << 1) | has_write);
+        write_varint(zigzag(read_addr - last_addr));
+        if (has_write)
+            write_varint(zigzag(write_addr - read_addr));
+        last_addr = read_addr;
+    }
+
+    void write_dram(long addr, bool is_write)
+    {
+        assert(kind == TraceHeader::Kind::DRAM);
+        uint64_t delta = zigzag(addr - last_addr);
+        assert(!(delta >> 63)); // room for the R/W bit
+        write_varint((delta << 1) | is_write);
+        last_addr = addr;
+    }
+
+    void write_timed(long clk, long addr, bool is_write, int coreid)
+    {
+        assert(kind == TraceHeader::Kind::Timed);
+        write_varint(zigzag(clk - last_clk));
+        uint64_t delta = zigzag(addr - last_addr);
+        assert(!(delta >> 63));
+        write_varint((delta << 1) | is_write);
+        write_varint(zigzag(coreid));
+        last_clk = clk;
+        last_addr = addr;
+    }
+
+private:
+    FILE* file;
+    TraceHeader::Kind kind;
+    long last_addr = 0;
+    long last_clk = 0;
+
+    void write_varint(uint64_t val)
+    {
+        unsigned char buf[10];
+        int len = 0;
+        while (val >= 0x80) {
+            buf[len++] = (val & 0x7f) | 0x80;
+            val >>= 7;
+        }
+        buf[len++] = val;
+        fwrite(buf, 1, len, file);
+    }
+};
+
+} /*namespace ramulator*/
+
+#endif /*__TRACEFORMAT_H*/
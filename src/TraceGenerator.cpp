@@ -0,0 +1,164 @@
+#include "TraceGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace ramulator;
+
+static const char* pattern_names[int(TraceGenerator::Pattern::MAX)] = {
+    "stream", "stride", "random", "pointer_chase", "row_hostile", "bank_conflict"
+};
+
+static const char* bubble_dist_names[int(TraceGenerator::BubbleDist::MAX)] = {
+    "fixed", "uniform", "geometric"
+};
+
+// Index of name in names, or exit if it is none of them
+static int lookup(const char* option, const std::string& name, const char** names, int count)
+{
+    for (int i = 0; i < count; i++)
+        if (name == names[i])
+            return i;
+    std::cerr << "Unknown " << option << ": " << name << std::endl;
+    exit(1);
+}
+
+static long get_long(const Config& configs, const char* option, long value)
+{
+    return configs.contains(option) ? atol(configs[option].c_str()) : value;
+}
+
+static double get_double(const Config& configs, const char* option, double value)
+{
+    return configs.contains(option) ? atof(configs[option].c_str()) : value;
+}
+
+TraceGenerator::TraceGenerator(const Config& configs, int id)
+{
+    pattern = Pattern(lookup("trace_generator", configs["trace_generator"],
+        pattern_names, int(Pattern::MAX)));
+    bubble_dist = BubbleDist(lookup("generator_bubble_dist",
+        configs.contains("generator_bubble_dist") ? configs["generator_bubble_dist"] : "fixed",
+        bubble_dist_names, int(BubbleDist::MAX)));
+
+    requests = get_long(configs, "generator_requests", 100000);
+    footprint = std::max(get_long(configs, "generator_footprint", 64 << 20) & ~63L, 64L);
+    stride = get_long(configs, "generator_stride", 4096);
+    row_size = get_long(configs, "generator_row_size", 8192);
+    row_stride = get_long(configs, "generator_row_stride", 65536);
+    write_ratio = get_double(configs, "generator_write_ratio", 0);
+    bubbles = get_double(configs, "generator_bubbles", 4);
+    id = get_long(configs, "generator_core", id);
+    seed = get_long(configs, "generator_seed", 1) + id;
+    assert(requests > 0 && stride > 0 && row_size > 0 && row_stride > 0);
+
+    base = id * footprint;
+    lines = footprint / 64;
+    for (line_bits = 1; (1L << line_bits) < lines; line_bits++);
+
+    restart();
+}
+
+void TraceGenerator::restart()
+{
+    generated = 0;
+    index = 0;
+    rng.seed(seed);
+}
+
+bool TraceGenerator::get_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr)
+{
+    if (generated == requests) {
+        restart();
+        return false;
+    }
+    generated++;
+    bubble_cnt = next_bubbles();
+    read_addr = next_addr();
+    has_write = uniform() < write_ratio;
+    if (has_write)
+        write_addr = next_addr();
+    return true;
+}
+
+bool TraceGenerator::get_request(long& req_addr, bool& is_write)
+{
+    if (generated == requests) {
+        restart();
+        return false;
+    }
+    generated++;
+    req_addr = next_addr();
+    is_write = uniform() < write_ratio;
+    return true;
+}
+
+long TraceGenerator::next_addr()
+{
+    long i = index++;
+    long offset = 0;
+    switch (pattern) {
+        case Pattern::Stream:
+            offset = (i % lines) * 64;
+            break;
+        case Pattern::Stride:
+            offset = (i * stride) % footprint;
+            break;
+        case Pattern::Random:
+            offset = (rng() % lines) * 64;
+            break;
+        case Pattern::PointerChase:
+            offset = permute(i % lines) * 64;
+            break;
+        case Pattern::RowHostile:
+            // also move through the columns, so that a row that comes
+            // around again is not accessed at the same line
+            offset = (i * row_size + (i * 64) % row_size) % footprint;
+            break;
+        case Pattern::BankConflict:
+            // no column offsets here: the lowest bits may select the channel
+            offset = (i * row_stride) % footprint;
+            break;
+        default:
+            assert(false);
+    }
+    return base + offset;
+}
+
+long TraceGenerator::next_bubbles()
+{
+    switch (bubble_dist) {
+        case BubbleDist::Fixed:
+            return lround(bubbles);
+        case BubbleDist::Uniform:
+            // mean of bubbles, between 0 and twice that
+            return rng() % (2 * lround(bubbles) + 1);
+        case BubbleDist::Geometric:
+            // number of failures before the first success, at a rate
+            // that gives a mean of bubbles
+            if (bubbles <= 0)
+                return 0;
+            return long(log(1 - uniform()) / log(bubbles / (bubbles + 1)));
+        default:
+            assert(false);
+    }
+}
+
+/*
+ * Map i in [0, lines) to a unique line in [0, lines). Odd multiplies, adds
+ * and right xor-shifts are each one-to-one on line_bits bits, so their
+ * composition is too; values past lines are mapped again until they land in
+ * range (cycle walking), which keeps the mapping one-to-one on [0, lines).
+ */
+long TraceGenerator::permute(long i) const
+{
+    uint64_t mask = (uint64_t(1) << line_bits) - 1;
+    uint64_t x = i;
+    do {
+        x = (x * 0x9E3779B97F4A7C15ull + seed * 0xBF58476D1CE4E5B9ull) & mask;
+        x ^= x >> (line_bits + 1) / 2;
+        x = (x * 0x94D049BB133111EBull) & mask;
+    } while (x >= uint64_t(lines));
+    return x;
+}
@@ -0,0 +1,83 @@
+#ifndef __TRACEGENERATOR_H
+#define __TRACEGENERATOR_H
+
+#include "Config.h"
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace ramulator
+{
+
+// Synthesizes the records of a cpu or dram trace, so that synthetic load
+// needs no trace file. A pass is generator_requests records long; like a
+// trace file, the generator then reports the end once and starts over with
+// the same records. Addresses are 64-byte lines within generator_footprint
+// bytes, starting at id * generator_footprint so that cores do not share
+// data (generator_core in the config overrides the id, e.g. to run the trace
+// of a core of a mix alone), and each line the pattern yields is either read
+// or written:
+//
+//   stream         consecutive lines
+//   stride         lines generator_stride bytes apart
+//   random         uniformly random lines
+//   pointer_chase  every line once in a random order, each read depending
+//                  on the one before it
+//   row_hostile    generator_row_size bytes apart: each access goes to the
+//                  next bank, and a bank never sees the same row twice in a row
+//   bank_conflict  generator_row_stride bytes apart: the next row of the
+//                  same bank every time
+//
+// generator_row_size and generator_row_stride are the bytes that share a
+// row and the distance between two rows of one bank under the address
+// mapping of the config (RoBaRaCoCh by default).
+class TraceGenerator
+{
+public:
+    enum class Pattern {
+        Stream, Stride, Random, PointerChase, RowHostile, BankConflict, MAX
+    };
+
+    enum class BubbleDist {
+        Fixed, Uniform, Geometric, MAX
+    };
+
+    TraceGenerator(const Config& configs, int id);
+
+    // One record in format 1 (see Trace), or false at the end of a pass
+    bool get_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr);
+    // One request in format 2, or false at the end of a pass
+    bool get_request(long& req_addr, bool& is_write);
+
+    // Whether each read has to wait for the read before it to be served
+    bool dependent_reads() const {return pattern == Pattern::PointerChase;}
+
+private:
+    Pattern pattern;
+    BubbleDist bubble_dist;
+    long requests;
+    long footprint;
+    long base;
+    long stride;
+    long row_size;
+    long row_stride;
+    double write_ratio;
+    double bubbles;
+    uint64_t seed;
+
+    long lines;
+    int line_bits;  // of the power of two at or above lines
+    long generated = 0;  // records in this pass
+    long index = 0;  // addresses in this pass
+    std::mt19937_64 rng;
+
+    void restart();
+    long next_addr();
+    long next_bubbles();
+    double uniform() {return (rng() >> 11) * (1.0 / (uint64_t(1) << 53));}
+    long permute(long i) const;
+};
+
+} /*namespace ramulator*/
+
+#endif /*__TRACEGENERATOR_H*/
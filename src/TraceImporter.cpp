@@ -0,0 +1,154 @@
+#include "TraceImporter.h"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace ramulator;
+
+static long get_long(const Config& configs, const char* option, long value)
+{
+    return configs.contains(option) ? atol(configs[option].c_str()) : value;
+}
+
+TraceImporter* TraceImporter::create(const Config& configs, const char* fname)
+{
+    const std::string& format = configs["trace_format"];
+    if (format == "" || format == "ramulator")
+        return NULL;
+    if (format == "champsim")
+        return new ChampSimImporter(configs, fname);
+    if (format == "dramsim2")
+        return new DRAMSim2Importer(fname);
+    std::cerr << "Unknown trace_format: " << format << std::endl;
+    exit(1);
+}
+
+TraceImporter::TraceImporter(const char* fname)
+    : fname(fname)
+{
+    if (!stream.open(fname)) {
+        std::cerr << "Bad trace file: " << fname << std::endl;
+        exit(1);
+    }
+}
+
+bool TraceImporter::get_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr)
+{
+    assert(false && "Not a cpu trace");
+    return false;
+}
+
+bool TraceImporter::get_timed_request(long& clk, long& req_addr, bool& is_write)
+{
+    assert(false && "Not a timed trace");
+    return false;
+}
+
+ChampSimImporter::ChampSimImporter(const Config& configs, const char* fname)
+    : TraceImporter(fname)
+{
+    static_assert(sizeof(Instruction) == 64, "ChampSim records are 64 bytes");
+    long size = get_long(configs, "champsim_filter_size", 2 << 20);
+    ways = get_long(configs, "champsim_filter_ways", 16);
+    sets = (size >> line_bits) / ways;
+    if (ways <= 0 || sets <= 0) {
+        std::cerr << "Bad ChampSim filter cache: " << size << " bytes in " << ways << " ways" << std::endl;
+        exit(1);
+    }
+    lines.resize(sets * ways);
+    restart();
+}
+
+void ChampSimImporter::restart()
+{
+    stream.rewind();
+    for (auto& line : lines)
+        line = Line();
+    uses = 0;
+    bubbles = 0;
+    misses.clear();
+}
+
+bool ChampSimImporter::get_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr)
+{
+    while (misses.empty()) {
+        Instruction inst;
+        if (!stream.read(&inst, sizeof(inst))) {
+            restart();
+            return false;
+        }
+        for (auto addr : inst.source_memory)
+            if (addr)
+                access(addr, false);
+        for (auto addr : inst.destination_memory)
+            if (addr)
+                access(addr, true);
+        if (misses.empty())
+            bubbles++;
+    }
+    const Miss& miss = misses.front();
+    bubble_cnt = miss.bubble_cnt;
+    read_addr = miss.addr;
+    has_write = miss.has_write;
+    write_addr = miss.write_addr;
+    misses.pop_front();
+    return true;
+}
+
+/*
+ * look the line up in the filter cache, and queue a miss for it.
+ */
+void ChampSimImporter::access(uint64_t addr, bool is_write)
+{
+    uint64_t tag = addr >> line_bits;
+    Line* set = &lines[(tag % sets) * ways];
+    Line* victim = set;
+    for (Line* line = set; line != set + ways; line++) {
+        if (line->valid && line->tag == tag) {
+            line->last_use = ++uses;
+            line->dirty |= is_write;
+            return;
+        }
+        if (victim->valid && (!line->valid || line->last_use < victim->last_use))
+            victim = line;
+    }
+
+    Miss miss = {misses.empty() ? bubbles : 0, long(tag << line_bits), victim->valid && victim->dirty,
+        long(victim->tag << line_bits)};
+    misses.push_back(miss);
+    bubbles = 0;
+    *victim = {tag, ++uses, true, is_write};
+}
+
+bool DRAMSim2Importer::get_timed_request(long& clk, long& req_addr, bool& is_write)
+{
+    char* line;
+    do {
+        if (!stream.get_line(line))
+            return false;
+        line_num++;
+        line += strspn(line, " \t");
+    } while (!*line || *line == '#');
+
+    unsigned long val;
+    const char* pos = parse_ulong(line, val, 16);
+    req_addr = val;
+    pos += strspn(pos, " \t");
+    size_t len = strcspn(pos, " \t");
+    std::string command(pos, len);
+    pos = parse_ulong(pos + len, val, 10);
+    clk = val;
+
+    if (command == "READ" || command == "IFETCH" || command == "P_MEM_RD" || command == "P_FETCH"
+            || command == "P_LOCK_RD" || command == "P_LOCK_WR")
+        is_write = false;
+    else if (command == "WRITE" || command == "P_MEM_WR" || command == "BOFF")
+        is_write = true;
+    else {
+        std::cerr << "Bad trace file: " << fname << ": unknown command on line " << line_num
+            << ": " << command << std::endl;
+        exit(1);
+    }
+    return true;
+}
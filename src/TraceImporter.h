@@ -0,0 +1,116 @@
+#ifndef __TRACEIMPORTER_H
+#define __TRACEIMPORTER_H
+
+#include "Config.h"
+#include "TraceFormat.h"
+#include "TraceStream.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace ramulator
+{
+
+// Reads the trace of another simulator in place of a Ramulator trace, with
+// trace_format in the config (see Trace). The file may be compressed like a
+// text trace, e.g. the .xz files that ChampSim traces come as.
+class TraceImporter
+{
+public:
+    // The importer for trace_format, or NULL for Ramulator's own formats
+    static TraceImporter* create(const Config& configs, const char* fname);
+
+    virtual ~TraceImporter() {}
+
+    // What the trace reads as: a cpu trace or a timed dram trace
+    virtual TraceHeader::Kind kind() const = 0;
+
+    // One record in format 1 (see Trace), or false at the end of the trace,
+    // which then starts over
+    virtual bool get_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr);
+    // One timed request, or false at the end of the trace
+    virtual bool get_timed_request(long& clk, long& req_addr, bool& is_write);
+
+protected:
+    std::string fname;
+    TraceStream stream;
+
+    TraceImporter(const char* fname);
+};
+
+// ChampSim instruction traces, as a cpu trace. ChampSim records every
+// instruction with the addresses that it loads from and stores to, so the
+// accesses go through a filter cache that stands in for the cache hierarchy:
+// champsim_filter_size bytes of 64-byte lines in champsim_filter_ways ways,
+// LRU, write-back and write-allocate. Each miss becomes a read, after the
+// instructions since the last miss as bubbles, with the dirty line that it
+// evicts, if any, as its writeback. An instruction that misses more than
+// once adds a record for each miss.
+class ChampSimImporter : public TraceImporter
+{
+public:
+    ChampSimImporter(const Config& configs, const char* fname);
+
+    TraceHeader::Kind kind() const {return TraceHeader::Kind::CPU;}
+    bool get_cpu_record(long& bubble_cnt, long& read_addr, bool& has_write, long& write_addr);
+
+private:
+    // input_instr of ChampSim's tracer
+    struct Instruction {
+        uint64_t ip;
+        uint8_t is_branch;
+        uint8_t branch_taken;
+        uint8_t destination_registers[2];
+        uint8_t source_registers[4];
+        uint64_t destination_memory[2];
+        uint64_t source_memory[4];
+    };
+
+    struct Miss {
+        long bubble_cnt;
+        long addr;
+        bool has_write;
+        long write_addr;
+    };
+
+    struct Line {
+        uint64_t tag;  // line address
+        uint64_t last_use;
+        bool valid;
+        bool dirty;
+    };
+
+    static const int line_bits = 6;
+    long sets;
+    int ways;
+    std::vector<Line> lines;  // set after set
+    uint64_t uses = 0;
+
+    long bubbles = 0;  // instructions since the last miss
+    std::deque<Miss> misses;  // of the last instruction, not handed out yet
+
+    void access(uint64_t addr, bool is_write);
+    void restart();
+};
+
+// DRAMSim2 transaction traces (.trc), as a timed dram trace. Each line is
+// "<address> <command> <cycle>"; READ, IFETCH, P_MEM_RD, P_FETCH,
+// P_LOCK_RD and P_LOCK_WR are reads, and WRITE, P_MEM_WR and BOFF writes.
+// The cycles are in the unit of trace_timestamps, memory cycles unless it
+// says ns.
+class DRAMSim2Importer : public TraceImporter
+{
+public:
+    DRAMSim2Importer(const char* fname) : TraceImporter(fname) {}
+
+    TraceHeader::Kind kind() const {return TraceHeader::Kind::Timed;}
+    bool get_timed_request(long& clk, long& req_addr, bool& is_write);
+
+private:
+    long line_num = 0;
+};
+
+} /*namespace ramulator*/
+
+#endif /*__TRACEIMPORTER_H*/
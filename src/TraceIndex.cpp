@@ -0,0 +1,129 @@
+#include "TraceIndex.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#include <zlib.h>
+
+using namespace ramulator;
+
+TraceIndex* TraceIndex::load(const char* trace_fname, TraceEncoding encoding)
+{
+    std::string fname = path(trace_fname);
+    FILE* file = fopen(fname.c_str(), "rb");
+    if (!file)
+        return NULL;
+
+    IndexHeader header;
+    struct stat st;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "RAMINDEX", sizeof(header.magic))
+            || header.version != current_version) {
+        std::cerr << "Bad trace index, ignored: " << fname << std::endl;
+        fclose(file);
+        return NULL;
+    }
+    if (stat(trace_fname, &st) || header.trace_size != st.st_size || header.trace_mtime != st.st_mtime
+            || header.encoding != encoding) {
+        std::cerr << "Trace index does not match the trace, ignored: " << fname << std::endl;
+        fclose(file);
+        return NULL;
+    }
+
+    TraceIndex* index = new TraceIndex(header.kind, encoding, header.interval);
+    index->fname = fname;
+    index->checkpoints.resize(header.checkpoints);
+    index->points.resize(header.points);
+    bool good = header.checkpoints > 0
+        && fread(index->checkpoints.data(), sizeof(Checkpoint), header.checkpoints, file) == size_t(header.checkpoints)
+        && fread(index->points.data(), sizeof(AccessPoint), header.points, file) == size_t(header.points);
+    fclose(file);
+    if (!good) {
+        std::cerr << "Bad trace index, ignored: " << fname << std::endl;
+        delete index;
+        return NULL;
+    }
+    return index;
+}
+
+bool TraceIndex::save(const char* trace_fname)
+{
+    struct stat st;
+    if (stat(trace_fname, &st))
+        return false;
+    fname = path(trace_fname);
+
+    IndexHeader header = IndexHeader();
+    memcpy(header.magic, "RAMINDEX", sizeof(header.magic));
+    header.version = current_version;
+    header.kind = kind;
+    header.encoding = encoding;
+    header.interval = interval;
+    header.trace_size = st.st_size;
+    header.trace_mtime = st.st_mtime;
+    header.checkpoints = checkpoints.size();
+    header.points = points.size();
+
+    // the windows go after the tables
+    long window = sizeof(header) + checkpoints.size() * sizeof(Checkpoint) + points.size() * sizeof(AccessPoint);
+    for (size_t i = 0; i < windows.size(); i++) {
+        points[i].window = window;
+        window += windows[i].size();
+    }
+
+    FILE* file = fopen(fname.c_str(), "wb");
+    if (!file)
+        return false;
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(checkpoints.data(), sizeof(Checkpoint), checkpoints.size(), file);
+    fwrite(points.data(), sizeof(AccessPoint), points.size(), file);
+    for (auto& w : windows)
+        fwrite(w.data(), 1, w.size(), file);
+    bool good = !ferror(file);
+    return !fclose(file) && good;
+}
+
+const TraceIndex::Checkpoint& TraceIndex::checkpoint(long insts) const
+{
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), insts,
+        [] (long insts, const Checkpoint& cp) {return insts < cp.insts;});
+    assert(it != checkpoints.begin());
+    return *(it - 1);
+}
+
+const TraceIndex::AccessPoint* TraceIndex::access_point(long offset) const
+{
+    auto it = std::upper_bound(points.begin(), points.end(), offset,
+        [] (long offset, const AccessPoint& point) {return offset < point.out;});
+    return it == points.begin() ? NULL : &*(it - 1);
+}
+
+void TraceIndex::add_window(const unsigned char* window, size_t size)
+{
+    uLongf bytes = compressBound(size);
+    std::vector<unsigned char> compressed(bytes);
+    int ret = compress2(compressed.data(), &bytes, window, size, Z_BEST_SPEED);
+    assert(ret == Z_OK);
+    compressed.resize(bytes);
+    points.back().window_bytes = bytes;
+    windows.push_back(std::move(compressed));
+}
+
+size_t TraceIndex::read_window(const AccessPoint& point, unsigned char* window) const
+{
+    std::vector<unsigned char> compressed(point.window_bytes);
+    uLongf size = window_size;
+    FILE* file = fopen(fname.c_str(), "rb");
+    bool good = file && !fseek(file, point.window, SEEK_SET)
+        && fread(compressed.data(), 1, compressed.size(), file) == compressed.size()
+        && uncompress(window, &size, compressed.data(), compressed.size()) == Z_OK;
+    if (file)
+        fclose(file);
+    if (!good) {
+        std::cerr << "Bad trace index: " << fname << std::endl;
+        exit(1);
+    }
+    return size;
+}
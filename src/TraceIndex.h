@@ -0,0 +1,99 @@
+#ifndef __TRACEINDEX_H
+#define __TRACEINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ramulator
+{
+
+/* Sidecar index of a trace, <trace file>.idx, to start reading the trace at
+ * an instruction count without decoding everything before it.
+ *
+ * Every interval records the index has a checkpoint: the instructions
+ * before the record (requests for a dram trace), the byte offset of the
+ * record in the decompressed text or the binary trace, and what the reader
+ * needs to go on from there. A compressed trace cannot be entered at any
+ * byte, so the index also has access points every span decompressed bytes:
+ * the start of a zstd frame, or for gzip a deflate block boundary along with
+ * the 32 KiB window that the data after it refers back to. A seek starts
+ * decompressing at the access point before the checkpoint and drops the
+ * bytes up to it, at most about span bytes.
+ *
+ * file: IndexHeader, the checkpoints, the access points, then the windows,
+ *       each zlib compressed, all in host byte order
+ */
+enum class TraceEncoding : uint32_t {
+    Plain, Gzip, Zstd, Binary, Xz
+};
+
+class TraceIndex
+{
+public:
+    static const long default_interval = 4096;
+    static const long span = 1 << 20;
+    static const size_t window_size = 1 << 15;
+
+    struct Checkpoint {
+        int64_t insts;  // before the record
+        int64_t offset;
+        int64_t line;  // lines of a text trace before the record
+        int64_t last_addr;  // of the record before, for the deltas of a binary trace
+    };
+
+    struct AccessPoint {
+        int64_t out;  // decompressed offset
+        int64_t in;  // compressed offset
+        int64_t bits;  // gzip: bits of the byte before in that belong to the next block
+        int64_t window;  // file offset of the window in the index, gzip only
+        int64_t window_bytes;  // compressed
+    };
+
+    uint32_t kind;  // TraceHeader::Kind
+    TraceEncoding encoding;
+    long interval;
+    std::vector<Checkpoint> checkpoints;
+    std::vector<AccessPoint> points;
+    std::vector<std::vector<unsigned char>> windows;  // while building, by point
+
+    TraceIndex(uint32_t kind, TraceEncoding encoding, long interval)
+        : kind(kind), encoding(encoding), interval(interval) {}
+
+    static std::string path(const char* trace_fname) {return std::string(trace_fname) + ".idx";}
+
+    // Load the index of the trace, if it has one that is up to date
+    static TraceIndex* load(const char* trace_fname, TraceEncoding encoding);
+    bool save(const char* trace_fname);
+
+    // The last checkpoint at or before insts
+    const Checkpoint& checkpoint(long insts) const;
+    // The last access point at or before offset, or NULL for the start
+    const AccessPoint* access_point(long offset) const;
+
+    // Keep the window of the access point just added
+    void add_window(const unsigned char* window, size_t size);
+    // Read the window of an access point back from the index; its size
+    size_t read_window(const AccessPoint& point, unsigned char* window) const;
+
+private:
+    std::string fname;
+
+    struct IndexHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t kind;
+        TraceEncoding encoding;
+        uint32_t unused;
+        int64_t interval;
+        int64_t trace_size;  // the index is stale once these change
+        int64_t trace_mtime;
+        int64_t checkpoints;
+        int64_t points;
+    };
+    static const uint32_t current_version = 1;
+};
+
+} /*namespace ramulator*/
+
+#endif /*__TRACEINDEX_H*/
@@ -0,0 +1,319 @@
+#include "TraceStream.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace ramulator;
+
+bool TraceStream::open(const char* fname)
+{
+    close();
+    this->fname = fname;
+
+    file = fopen(fname, "rb");
+    if (!file)
+        return false;
+    in.resize(input_size);
+    in_begin = in_end = 0;
+    in_offset = 0;
+    read_input(6);
+    const unsigned char* magic = in.data();
+    if (in_end >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        format = TraceEncoding::Zstd;
+    else if (in_end >= 6 && !memcmp(magic, "\xfd" "7zXZ\0", 6))
+        format = TraceEncoding::Xz;
+    else if (in_end >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+        format = TraceEncoding::Gzip;
+    else
+        format = TraceEncoding::Plain;
+
+    if (format == TraceEncoding::Zstd) {
+#ifdef RAMULATOR_ZSTD
+        zstd = ZSTD_createDStream();
+#else
+        std::cerr << "Ramulator was built without zstd, cannot read trace file: " << fname << std::endl;
+        exit(1);
+#endif
+    } else if (format == TraceEncoding::Xz) {
+#ifndef RAMULATOR_LZMA
+        std::cerr << "Ramulator was built without xz, cannot read trace file: " << fname << std::endl;
+        exit(1);
+#endif
+    } else if (format == TraceEncoding::Gzip) {
+        gz = z_stream();
+        if (inflateInit2(&gz, 15 + 16) != Z_OK)
+            bad_trace(gz.msg);
+    }
+
+    buf.resize(block_size);
+    rewind();
+    return true;
+}
+
+void TraceStream::close()
+{
+    if (!file)
+        return;
+    if (format == TraceEncoding::Gzip)
+        inflateEnd(&gz);
+#ifdef RAMULATOR_ZSTD
+    if (zstd)
+        ZSTD_freeDStream(zstd);
+    zstd = NULL;
+#endif
+#ifdef RAMULATOR_LZMA
+    lzma_end(&xz);
+#endif
+    fclose(file);
+    file = NULL;
+}
+
+void TraceStream::rewind()
+{
+    restart(0, 0);
+}
+
+/*
+ * go on reading at file offset in_pos, which decompresses to out_pos
+ */
+void TraceStream::restart(long in_pos, long out_pos)
+{
+    fseek(file, in_pos, SEEK_SET);
+    in_offset = in_pos;
+    in_begin = in_end = 0;
+    if (format == TraceEncoding::Gzip)
+        inflateReset2(&gz, 15 + 16);
+#ifdef RAMULATOR_ZSTD
+    if (format == TraceEncoding::Zstd)
+        ZSTD_initDStream(zstd);
+#endif
+#ifdef RAMULATOR_LZMA
+    // the decoder cannot be reset, only set up again
+    if (format == TraceEncoding::Xz && lzma_stream_decoder(&xz, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK)
+        bad_trace("cannot set up the xz decoder");
+    xz_end = false;
+#endif
+    gz_raw = gz_end = false;
+    out_total = out_offset = last_point = out_pos;
+    begin = end = 0;
+    done = false;
+}
+
+void TraceStream::seek(long offset, const TraceIndex& index)
+{
+    const TraceIndex::AccessPoint* point = index.access_point(offset);
+    if (format == TraceEncoding::Plain)
+        restart(offset, offset);
+    else if (!point || format == TraceEncoding::Xz)
+        restart(0, 0);
+    else if (format == TraceEncoding::Zstd)
+        restart(point->in, point->out);
+    else {
+        // a deflate block that starts in the middle of a byte, with the
+        // window of what was decompressed before it
+        restart(point->in - (point->bits ? 1 : 0), point->out);
+        inflateReset2(&gz, -15);
+        gz_raw = true;
+        if (point->bits) {
+            if (!read_input(1))
+                bad_trace("unexpected end of file");
+            inflatePrime(&gz, point->bits, in[in_begin++] >> (8 - point->bits));
+        }
+        unsigned char window[TraceIndex::window_size];
+        size_t size = index.read_window(*point, window);
+        inflateSetDictionary(&gz, window, size);
+    }
+
+    // drop what comes before offset
+    while (offset - out_offset > long(end)) {
+        out_offset += end;
+        end = fill(buf.data(), buf.size());
+        if (!end)
+            bad_trace("shorter than its index");
+    }
+    begin = offset - out_offset;
+}
+
+bool TraceStream::get_line(char*& line)
+{
+    while (true) {
+        char* data = buf.data();
+        char* nl = (char*)memchr(data + begin, '\n', end - begin);
+        if (nl) {
+            *nl = '\0';
+            line = data + begin;
+            begin = nl + 1 - data;
+            return true;
+        }
+        if (done)
+            return false;
+
+        // keep the partial line and decompress the next block behind it
+        memmove(data, data + begin, end - begin);
+        out_offset += begin;
+        end -= begin;
+        begin = 0;
+        if (end == buf.size())
+            buf.resize(2 * buf.size());
+        size_t n = fill(buf.data() + end, buf.size() - end);
+        done = !n;
+        end += n;
+    }
+}
+
+bool TraceStream::read(void* dst, size_t size)
+{
+    char* out = (char*)dst;
+    while (size) {
+        if (begin == end) {
+            out_offset += end;
+            begin = 0;
+            end = done ? 0 : fill(buf.data(), buf.size());
+            done = !end;
+            if (done)
+                return false;
+        }
+        size_t n = min(size, end - begin);
+        memcpy(out, buf.data() + begin, n);
+        begin += n;
+        out += n;
+        size -= n;
+    }
+    return true;
+}
+
+size_t TraceStream::fill(char* dst, size_t size)
+{
+    size_t n;
+    if (format == TraceEncoding::Gzip)
+        n = inflate_gzip(dst, size);
+    else if (format == TraceEncoding::Zstd)
+        n = decompress_zstd(dst, size);
+    else if (format == TraceEncoding::Xz)
+        n = decompress_xz(dst, size);
+    else {
+        // the input buffer may still hold the start of the file
+        n = min(size, in_end - in_begin);
+        memcpy(dst, in.data() + in_begin, n);
+        in_begin += n;
+        n += fread(dst + n, 1, size - n, file);
+    }
+    out_total += n;
+    return n;
+}
+
+size_t TraceStream::inflate_gzip(char* dst, size_t size)
+{
+    gz.next_out = (Bytef*)dst;
+    gz.avail_out = size;
+    while (gz.avail_out == size) {
+        if (gz_end) {
+            // another gzip member may follow, after the trailer of this one
+            // if it was inflated without its header; anything else after the
+            // end is ignored, like gzread() does
+            if (gz_raw) {
+                if (!read_input(8))
+                    bad_trace("unexpected end of file");
+                in_begin += 8;
+                gz_raw = false;
+            }
+            if (!read_input(2) || in[in_begin] != 0x1f || in[in_begin + 1] != 0x8b)
+                break;
+            inflateReset2(&gz, 15 + 16);
+            gz_end = false;
+        }
+        if (in_begin == in_end && !read_input(1))
+            bad_trace("unexpected end of file");
+
+        gz.next_in = in.data() + in_begin;
+        gz.avail_in = in_end - in_begin;
+        int ret = inflate(&gz, points ? Z_BLOCK : Z_NO_FLUSH);
+        in_begin = gz.next_in - in.data();
+        if (ret == Z_STREAM_END)
+            gz_end = true;
+        else if (ret != Z_OK && ret != Z_BUF_ERROR)
+            bad_trace(gz.msg ? gz.msg : "bad compressed data");
+
+        // at the end of a block that is not the last, decompression can
+        // start over with the window
+        long out = out_total + (size - gz.avail_out);
+        if (points && (gz.data_type & 128) && !(gz.data_type & 64) && out - last_point >= TraceIndex::span) {
+            points->points.push_back({out, in_offset + long(in_begin), gz.data_type & 7, 0, 0});
+            unsigned char window[TraceIndex::window_size];
+            uInt window_size = sizeof(window);
+            inflateGetDictionary(&gz, window, &window_size);
+            points->add_window(window, window_size);
+            last_point = out;
+        }
+    }
+    return size - gz.avail_out;
+}
+
+size_t TraceStream::decompress_zstd(char* dst, size_t size)
+{
+#ifdef RAMULATOR_ZSTD
+    ZSTD_outBuffer output = {dst, size, 0};
+    while (!output.pos) {
+        if (in_begin == in_end && !read_input(1))
+            break;
+        ZSTD_inBuffer input = {in.data(), in_end, in_begin};
+        size_t ret = ZSTD_decompressStream(zstd, &output, &input);
+        in_begin = input.pos;
+        if (ZSTD_isError(ret))
+            bad_trace(ZSTD_getErrorName(ret));
+
+        // a frame ends here, the next one decompresses on its own
+        long out = out_total + output.pos;
+        if (points && !ret && out - last_point >= TraceIndex::span) {
+            points->points.push_back({out, in_offset + long(in_begin), 0, 0, 0});
+            last_point = out;
+        }
+    }
+    return output.pos;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * xz streams have no access points: a seek decompresses from the start.
+ */
+size_t TraceStream::decompress_xz(char* dst, size_t size)
+{
+#ifdef RAMULATOR_LZMA
+    xz.next_out = (uint8_t*)dst;
+    xz.avail_out = size;
+    while (xz.avail_out == size && !xz_end) {
+        bool last = in_begin == in_end && !read_input(1);
+        xz.next_in = in.data() + in_begin;
+        xz.avail_in = in_end - in_begin;
+        lzma_ret ret = lzma_code(&xz, last ? LZMA_FINISH : LZMA_RUN);
+        in_begin = xz.next_in - in.data();
+        if (ret == LZMA_STREAM_END)
+            xz_end = true;
+        else if (ret != LZMA_OK)
+            bad_trace(ret == LZMA_BUF_ERROR ? "unexpected end of file" : "bad compressed data");
+    }
+    return size - xz.avail_out;
+#else
+    return 0;
+#endif
+}
+
+bool TraceStream::read_input(size_t n)
+{
+    if (in_end - in_begin >= n)
+        return true;
+    memmove(in.data(), in.data() + in_begin, in_end - in_begin);
+    in_offset += in_begin;
+    in_end -= in_begin;
+    in_begin = 0;
+    in_end += fread(in.data() + in_end, 1, in.size() - in_end, file);
+    return in_end >= n;
+}
+
+void TraceStream::bad_trace(const char* error)
+{
+    std::cerr << "Bad trace file: " << fname << ": " << error << std::endl;
+    exit(1);
+}
@@ -0,0 +1,143 @@
+#ifndef __TRACESTREAM_H
+#define __TRACESTREAM_H
+
+#include "TraceIndex.h"
+#include <cctype>
+#include <cstdio>
+#include <vector>
+#include <zlib.h>
+#ifdef RAMULATOR_ZSTD
+#include <zstd.h>
+#endif
+#ifdef RAMULATOR_LZMA
+#include <lzma.h>
+#endif
+
+using namespace std;
+
+namespace ramulator
+{
+
+// Reads the lines of a text trace, or the records of a binary one that is
+// not mapped (see TraceImporter), that may be plain, gzip, zstd or xz
+// compressed (told apart by the magic number at the start of the file). The
+// file is decompressed a block at a time into a buffer that is reused for the
+// whole trace, and lines are handed out in place from that buffer. With the
+// access points of a TraceIndex, reading can also start in the middle of the
+// trace.
+class TraceStream
+{
+public:
+    static const size_t block_size = 1 << 20;
+    static const size_t input_size = 1 << 18;
+
+    TraceStream() {}
+    ~TraceStream() {close();}
+
+    TraceStream(const TraceStream&) = delete;
+    TraceStream& operator=(const TraceStream&) = delete;
+
+    bool open(const char* fname);
+    bool good() const {return file;}
+    TraceEncoding encoding() const {return format;}
+
+    // Next line, NUL-terminated without its newline. It stays valid until the
+    // next call. Like getline(), a last line that has no newline is dropped.
+    bool get_line(char*& line);
+
+    // Next size bytes, or false at the end of the trace
+    bool read(void* dst, size_t size);
+
+    // Decompressed offset of the next line
+    long tell() const {return out_offset + begin;}
+
+    // Start over from the beginning of the trace
+    void rewind();
+
+    // Go on reading at the given decompressed offset, through the access
+    // points of index
+    void seek(long offset, const TraceIndex& index);
+
+    // Add access points to index while reading the trace
+    void add_points(TraceIndex* index) {points = index;}
+
+private:
+    const char* fname = NULL;
+    TraceEncoding format = TraceEncoding::Plain;
+    FILE* file = NULL;
+
+    // compressed input
+    vector<unsigned char> in;
+    size_t in_begin = 0;  // first byte not decompressed yet
+    size_t in_end = 0;
+    long in_offset = 0;  // file offset of in[0]
+
+    z_stream gz;
+    bool gz_raw = false;  // inflating from an access point, without the gzip header
+    bool gz_end = false;  // at the end of a gzip member
+#ifdef RAMULATOR_ZSTD
+    ZSTD_DStream* zstd = NULL;
+#endif
+#ifdef RAMULATOR_LZMA
+    lzma_stream xz = LZMA_STREAM_INIT;
+    bool xz_end = false;  // past the last stream
+#endif
+
+    vector<char> buf;
+    size_t begin = 0;  // first byte not handed out yet
+    size_t end = 0;  // end of the decompressed bytes
+    long out_offset = 0;  // decompressed offset of buf[0]
+    long out_total = 0;  // decompressed bytes produced so far
+    bool done = false;  // nothing left to decompress
+
+    TraceIndex* points = NULL;
+    long last_point = 0;  // decompressed offset of the last access point
+
+    void close();
+    void restart(long in_pos, long out_pos);
+    // Decompress up to size bytes to dst; 0 at the end of the file
+    size_t fill(char* dst, size_t size);
+    size_t inflate_gzip(char* dst, size_t size);
+    size_t decompress_zstd(char* dst, size_t size);
+    size_t decompress_xz(char* dst, size_t size);
+    // Make at least n bytes of input available, unless the file ends first
+    bool read_input(size_t n);
+    void bad_trace(const char* error);
+};
+
+// Parse the unsigned number at pos like strtoul() does, but without its
+// locale and errno handling: leading blanks are skipped, and base 0 reads a
+// 0x prefix as hex and a leading 0 as octal. Returns the end of the number,
+// or pos if there is none.
+inline const char* parse_ulong(const char* pos, unsigned long& val, int base)
+{
+    const char* start = pos;
+    while (*pos == ' ' || *pos == '\t')
+        pos++;
+    if ((base == 0 || base == 16) && pos[0] == '0' && (pos[1] | 0x20) == 'x' && isxdigit(pos[2])) {
+        pos += 2;
+        base = 16;
+    } else if (base == 0)
+        base = pos[0] == '0' ? 8 : 10;
+
+    const char* digits = pos;
+    val = 0;
+    while (true) {
+        unsigned int c = (unsigned char)*pos, digit;
+        if (c - '0' < 10)
+            digit = c - '0';
+        else if ((c | 0x20) - 'a' < 26)
+            digit = (c | 0x20) - 'a' + 10;
+        else
+            break;
+        if (digit >= unsigned(base))
+            break;
+        val = val * base + digit;
+        pos++;
+    }
+    return pos == digits ? start : pos;
+}
+
+} /*namespace ramulator*/
+
+#endif /*__TRACESTREAM_H*/
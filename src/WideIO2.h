@@ -106,6 +106,8 @@ public:
         State::MAX, State::PowerUp, State::Closed, State::Closed, State::MAX
     };
 
+    static const int max_open_rows = 1; // rows a bank (or subarray) can hold open at once
+
     /* Translate */
     Command translate[int(Request::Type::MAX)] = {
         Command::RD,  Command::WR,
@@ -113,12 +115,14 @@ public:
     };
 
     /* Prerequisite */
-    function<Command(DRAM<WideIO2>*, Command cmd, int)> prereq[int(Level::MAX)][int(Command::MAX)];
+    static Command prereq(DRAM<WideIO2>* node, Command cmd, int id);
 
-    // SAUGATA: added function object container for row hit status
+    // SAUGATA: added row hit status
     /* Row hit */
-    function<bool(DRAM<WideIO2>*, Command cmd, int)> rowhit[int(Level::MAX)][int(Command::MAX)];
-    function<bool(DRAM<WideIO2>*, Command cmd, int)> rowopen[int(Level::MAX)][int(Command::MAX)];
+    static bool has_rowhit(Level level, Command cmd);
+    static bool rowhit(DRAM<WideIO2>* node, Command cmd, int id);
+    static bool has_rowopen(Level level, Command cmd);
+    static bool rowopen(DRAM<WideIO2>* node, Command cmd, int id);
 
     /* Timing */
     struct TimingEntry
@@ -129,9 +133,10 @@ public:
         bool sibling;
     }; 
     vector<TimingEntry> timing[int(Level::MAX)][int(Command::MAX)];
+    static const int max_dist = 4; // longest command history looked back on by a TimingEntry
 
     /* Lambda */
-    function<void(DRAM<WideIO2>*, int)> lambda[int(Level::MAX)][int(Command::MAX)];
+    static void lambda(DRAM<WideIO2>* node, Command cmd, int id);
 
     /* Organization */
     enum class Org : int
@@ -185,13 +190,155 @@ public:
     int read_latency;
 
 private:
-    void init_lambda();
-    void init_prereq();
-    void init_rowhit();  // SAUGATA: added function to check for row hits
-    void init_rowopen();
     void init_timing();
 };
 
+template <> struct has_static_rules<WideIO2> : true_type {};
+
+inline WideIO2::Command WideIO2::prereq(DRAM<WideIO2>* node, Command cmd, int id)
+{
+    switch (int(node->level)) {
+        case int(Level::Rank):
+            switch (int(cmd)) {
+                // RD, WR
+                case int(Command::RD):
+                case int(Command::WR):
+                    switch (int(node->state)) {
+                        case int(State::PowerUp): return Command::MAX;
+                        case int(State::ActPowerDown): return Command::PDX;
+                        case int(State::PrePowerDown): return Command::PDX;
+                        case int(State::SelfRefresh): return Command::SREFX;
+                        default: assert(false);
+                    }
+                // REF
+                case int(Command::REF):
+                    for (auto bank : node->children) {
+                        if (bank->state == State::Closed)
+                            continue;
+                        return Command::PRA;
+                    }
+                    return Command::REF;
+                // PD
+                case int(Command::PD):
+                    switch (int(node->state)) {
+                        case int(State::PowerUp): return Command::PD;
+                        case int(State::ActPowerDown): return Command::PD;
+                        case int(State::PrePowerDown): return Command::PD;
+                        case int(State::SelfRefresh): return Command::SREFX;
+                        default: assert(false);
+                    }
+                // SR
+                case int(Command::SREF):
+                    switch (int(node->state)) {
+                        case int(State::PowerUp): return Command::SREF;
+                        case int(State::ActPowerDown): return Command::PDX;
+                        case int(State::PrePowerDown): return Command::PDX;
+                        case int(State::SelfRefresh): return Command::SREF;
+                        default: assert(false);
+                    }
+                default: return Command::MAX;
+            }
+        case int(Level::Bank):
+            switch (int(cmd)) {
+                // RD, WR
+                case int(Command::RD):
+                case int(Command::WR):
+                    switch (int(node->state)) {
+                        case int(State::Closed): return Command::ACT;
+                        case int(State::Opened):
+                            if (node->row_state.is_open(id))
+                                return cmd;
+                            return Command::PRE;
+                        default: assert(false);
+                    }
+                default: return Command::MAX;
+            }
+        default: return Command::MAX;
+    }
+}
+
+// SAUGATA: added row hit check functions to see if the desired location is currently open
+inline bool WideIO2::has_rowhit(Level level, Command cmd)
+{
+    return level == Level::Bank && (cmd == Command::RD || cmd == Command::WR);
+}
+
+inline bool WideIO2::rowhit(DRAM<WideIO2>* node, Command cmd, int id)
+{
+    switch (int(node->state)) {
+        case int(State::Closed): return false;
+        case int(State::Opened):
+            if (node->row_state.is_open(id))
+                return true;
+            return false;
+        default: assert(false);
+    }
+}
+
+inline bool WideIO2::has_rowopen(Level level, Command cmd)
+{
+    // row open status is not tracked: a request that misses is never counted as a conflict
+    return false;
+}
+
+inline bool WideIO2::rowopen(DRAM<WideIO2>* node, Command cmd, int id)
+{
+    switch (int(node->state)) {
+        case int(State::Closed): return false;
+        case int(State::Opened): return true;
+        default: assert(false);
+    }
+}
+
+inline void WideIO2::lambda(DRAM<WideIO2>* node, Command cmd, int id)
+{
+    switch (int(node->level)) {
+        case int(Level::Rank):
+            switch (int(cmd)) {
+                case int(Command::PRA):
+                    for (auto bank : node->children) {
+                        bank->state = State::Closed;
+                        bank->row_state.clear();
+                    }
+                    return;
+                case int(Command::PD):
+                    for (auto bank : node->children) {
+                        if (bank->state == State::Closed)
+                            continue;
+                        node->state = State::ActPowerDown;
+                        return;
+                    }
+                    node->state = State::PrePowerDown;
+                    return;
+                case int(Command::PDX):
+                    node->state = State::PowerUp;
+                    return;
+                case int(Command::SREF):
+                    node->state = State::SelfRefresh;
+                    return;
+                case int(Command::SREFX):
+                    node->state = State::PowerUp;
+                    return;
+                default: return;
+            }
+        case int(Level::Bank):
+            switch (int(cmd)) {
+                case int(Command::ACT):
+                    node->state = State::Opened;
+                    node->row_state.open(id);
+                    return;
+                case int(Command::PRE):
+                case int(Command::RDA):
+                case int(Command::WRA):
+                    node->state = State::Closed;
+                    node->row_state.clear();
+                    return;
+                default: return;
+            }
+        default: return;
+    }
+}
+
 } /*namespace ramulator*/
 
 #endif /*__WIDEIO2_H*/
@@ -0,0 +1,99 @@
+#ifndef __WORKERPOOL_H
+#define __WORKERPOOL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace ramulator
+{
+
+// Persistent threads that run a job for every index of a range and wait until
+// all of them are done. The calling thread takes its share of the indices, so
+// a pool of N threads starts N-1 workers. Jobs are short and come back to
+// back, so waiting threads spin for a while before they start yielding.
+class WorkerPool
+{
+public:
+    WorkerPool(int threads) : threads(threads)
+    {
+        for (int t = 1; t < threads; t++)
+            workers.push_back(thread(&WorkerPool::loop, this, t));
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool()
+    {
+        stop = true;
+        generation.fetch_add(1, memory_order_release);
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    int size() const {return threads;}
+
+    // Call job(i) for each i in [0, n); thread t takes t, t + size(), ...
+    template <typename F>
+    void run(int n, F& job)
+    {
+        this->n = n;
+        this->job = &job;
+        call = &call_job<F>;
+        remaining.store(threads - 1, memory_order_relaxed);
+        generation.fetch_add(1, memory_order_release);
+
+        work(0);
+        for (int spins = 0; remaining.load(memory_order_acquire); spins++)
+            pause(spins);
+    }
+
+private:
+    int threads;
+    vector<thread> workers;
+
+    atomic<long> generation{0};  // bumped for each run() and to stop
+    atomic<int> remaining{0};  // workers that have not finished this run
+    bool stop = false;
+
+    int n = 0;
+    void* job = NULL;
+    void (*call)(void*, int) = NULL;
+
+    template <typename F>
+    static void call_job(void* job, int i) {(*static_cast<F*>(job))(i);}
+
+    static void pause(int spins)
+    {
+        if (spins >= 1000)
+            this_thread::yield();
+    }
+
+    void work(int t)
+    {
+        for (int i = t; i < n; i += threads)
+            call(job, i);
+    }
+
+    void loop(int t)
+    {
+        long seen = 0;
+        while (true) {
+            long cur;
+            for (int spins = 0; (cur = generation.load(memory_order_acquire)) == seen; spins++)
+                pause(spins);
+            seen = cur;
+            if (stop)
+                return;
+            work(t);
+            remaining.fetch_sub(1, memory_order_release);
+        }
+    }
+};
+
+} /*namespace ramulator*/
+
+#endif /*__WORKERPOOL_H*/